@@ -1,10 +1,42 @@
 #define _POSIX_C_SOURCE 200809L
+#define _XOPEN_SOURCE 700
 #include "goon.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h>
+#include <inttypes.h>
 #include <libgen.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_WIDTH 32
+#define SIMD_FULL_MASK 0xFFFFFFFFu
+typedef __m256i Simd_Vec;
+#define simd_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define simd_splat(c) _mm256_set1_epi8((char)(c))
+#define simd_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define simd_gt(a, b) _mm256_cmpgt_epi8(a, b)
+#define simd_or(a, b) _mm256_or_si256(a, b)
+#define simd_and(a, b) _mm256_and_si256(a, b)
+#define simd_mask(a) ((uint32_t)_mm256_movemask_epi8(a))
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_WIDTH 16
+#define SIMD_FULL_MASK 0xFFFFu
+typedef __m128i Simd_Vec;
+#define simd_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define simd_splat(c) _mm_set1_epi8((char)(c))
+#define simd_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define simd_gt(a, b) _mm_cmpgt_epi8(a, b)
+#define simd_or(a, b) _mm_or_si128(a, b)
+#define simd_and(a, b) _mm_and_si128(a, b)
+#define simd_mask(a) ((uint32_t)_mm_movemask_epi8(a))
+#endif
 
 typedef enum {
     TOK_EOF,
@@ -37,136 +69,430 @@ typedef enum {
 
 typedef struct {
     Token_Type type;
+    uint32_t start;
+    uint32_t len;
     union {
         int64_t integer;
-        char *string;
+        const Goon_Symbol *sym;
+        uint32_t hash;
     } data;
 } Token;
 
+typedef struct Arena_Chunk {
+    struct Arena_Chunk *next;
+    size_t used;
+    size_t cap;
+    char data[];
+} Arena_Chunk;
+
+typedef struct Goon_Arena {
+    Arena_Chunk *head;
+    size_t reserved;
+    Goon_Ctx *owner;
+} Arena;
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN 8
+
+static void *arena_alloc(Arena *a, size_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    Arena_Chunk *chunk = a->head;
+    if (!chunk || chunk->cap - chunk->used < size) {
+        size_t cap = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+        Goon_Ctx *owner = a->owner;
+        if (owner && owner->memory_limit) {
+            size_t used = owner->stats.bytes_reserved;
+            size_t avail = owner->memory_limit > used ? owner->memory_limit - used : 0;
+            if (size > avail) {
+                owner->memory_exceeded = true;
+                return NULL;
+            }
+            if (cap > avail) cap = avail;
+        }
+        chunk = malloc(sizeof(Arena_Chunk) + cap);
+        if (!chunk) return NULL;
+        chunk->used = 0;
+        chunk->cap = cap;
+        a->reserved += cap;
+        if (owner) {
+            owner->stats.bytes_reserved += cap;
+            if (owner->stats.bytes_reserved > owner->stats.peak_bytes) {
+                owner->stats.peak_bytes = owner->stats.bytes_reserved;
+            }
+        }
+        if (a->head && size > ARENA_CHUNK_SIZE) {
+            chunk->next = a->head->next;
+            a->head->next = chunk;
+        } else {
+            chunk->next = a->head;
+            a->head = chunk;
+        }
+    }
+    void *mem = chunk->data + chunk->used;
+    chunk->used += size;
+    return mem;
+}
+
+static void arena_free(Arena *a) {
+    Arena_Chunk *chunk = a->head;
+    while (chunk) {
+        Arena_Chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    a->head = NULL;
+    if (a->owner) a->owner->stats.bytes_reserved -= a->reserved;
+    a->reserved = 0;
+}
+
+static void arena_reset(Arena *a) {
+    Arena_Chunk *keep = a->head;
+    if (!keep) return;
+    if (keep->cap > ARENA_CHUNK_SIZE) {
+        arena_free(a);
+        return;
+    }
+    Arena_Chunk *chunk = keep->next;
+    while (chunk) {
+        Arena_Chunk *next = chunk->next;
+        a->reserved -= chunk->cap;
+        if (a->owner) a->owner->stats.bytes_reserved -= chunk->cap;
+        free(chunk);
+        chunk = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+}
+
+static bool arena_owns(const Arena *a, const void *ptr) {
+    for (const Arena_Chunk *chunk = a->head; chunk; chunk = chunk->next) {
+        if ((const char *)ptr >= chunk->data && (const char *)ptr < chunk->data + chunk->cap) return true;
+    }
+    return false;
+}
+
+typedef struct Goon_Node Node;
+typedef struct Goon_Proto Proto;
+
+struct Goon_Source {
+    char *name;
+    char *text;
+    size_t len;
+    bool mapped;
+    bool borrowed;
+    Token *tokens;
+    size_t token_count;
+    size_t *lines;
+    size_t line_count;
+    Arena arena;
+    Node **exprs;
+    size_t expr_count;
+    Proto *main;
+    Proto *protos;
+    Goon_Module *module;
+    Goon_Source *next;
+};
+
+struct Goon_Module {
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    off_t size;
+    Goon_Value *value;
+    Goon_Ctx *loader;
+    Goon_Module **deps;
+    size_t dep_count;
+    size_t dep_cap;
+    bool visited;
+    Goon_Module *next;
+};
+
+struct Goon_Symtab {
+    Goon_Symbol **slots;
+    size_t cap;
+    size_t count;
+    size_t refs;
+};
+
+static uint32_t hash_bytes(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static Goon_Symtab *symtab_create(void) {
+    Goon_Symtab *tab = malloc(sizeof(Goon_Symtab));
+    if (!tab) return NULL;
+    tab->cap = 256;
+    tab->count = 0;
+    tab->refs = 1;
+    tab->slots = calloc(tab->cap, sizeof(Goon_Symbol *));
+    if (!tab->slots) {
+        free(tab);
+        return NULL;
+    }
+    return tab;
+}
+
+static void symtab_release(Goon_Symtab *tab) {
+    if (!tab || --tab->refs > 0) return;
+    for (size_t i = 0; i < tab->cap; i++) {
+        free(tab->slots[i]);
+    }
+    free(tab->slots);
+    free(tab);
+}
+
+static Goon_Symbol **symtab_slot(Goon_Symtab *tab, const char *name, size_t len, uint32_t hash) {
+    size_t mask = tab->cap - 1;
+    size_t i = hash & mask;
+    for (;;) {
+        Goon_Symbol *sym = tab->slots[i];
+        if (!sym || (sym->hash == hash && sym->len == len && memcmp(sym->name, name, len) == 0)) {
+            return &tab->slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+static bool symtab_grow(Goon_Symtab *tab) {
+    size_t new_cap = tab->cap * 2;
+    Goon_Symbol **new_slots = calloc(new_cap, sizeof(Goon_Symbol *));
+    if (!new_slots) return false;
+    for (size_t i = 0; i < tab->cap; i++) {
+        Goon_Symbol *sym = tab->slots[i];
+        if (!sym) continue;
+        size_t j = sym->hash & (new_cap - 1);
+        while (new_slots[j]) j = (j + 1) & (new_cap - 1);
+        new_slots[j] = sym;
+    }
+    free(tab->slots);
+    tab->slots = new_slots;
+    tab->cap = new_cap;
+    return true;
+}
+
+static const Goon_Symbol *symtab_intern_hash(Goon_Symtab *tab, const char *name, size_t len, uint32_t hash) {
+    Goon_Symbol **slot = symtab_slot(tab, name, len, hash);
+    if (*slot) return *slot;
+
+    if ((tab->count + 1) * 2 > tab->cap) {
+        if (!symtab_grow(tab)) return NULL;
+        slot = symtab_slot(tab, name, len, hash);
+    }
+
+    Goon_Symbol *sym = malloc(sizeof(Goon_Symbol) + len + 1);
+    if (!sym) return NULL;
+    sym->hash = hash;
+    sym->len = (uint32_t)len;
+    memcpy(sym->name, name, len);
+    sym->name[len] = '\0';
+    *slot = sym;
+    tab->count++;
+    return sym;
+}
+
+static const Goon_Symbol *symtab_intern(Goon_Symtab *tab, const char *name, size_t len) {
+    return symtab_intern_hash(tab, name, len, hash_bytes(name, len));
+}
+
 typedef struct {
     const char *src;
     size_t pos;
     size_t len;
-    size_t line;
-    size_t col;
-    size_t line_start;
-    size_t token_start;
-    Token current;
-    char *error;
-    size_t error_line;
-    size_t error_col;
+    Goon_Symtab *symbols;
+    Token *tokens;
+    size_t count;
+    size_t cap;
+    const char *error;
+    size_t error_pos;
 } Lexer;
 
-static void lexer_init(Lexer *lex, const char *src) {
+static void lexer_init(Lexer *lex, const char *src, size_t len, Goon_Symtab *symbols) {
     lex->src = src;
     lex->pos = 0;
-    lex->len = strlen(src);
-    lex->line = 1;
-    lex->col = 1;
-    lex->line_start = 0;
-    lex->token_start = 0;
-    lex->current.type = TOK_EOF;
-    lex->current.data.string = NULL;
+    lex->len = len;
+    lex->symbols = symbols;
+    lex->tokens = NULL;
+    lex->count = 0;
+    lex->cap = 0;
     lex->error = NULL;
-    lex->error_line = 0;
-    lex->error_col = 0;
+    lex->error_pos = 0;
 }
 
 static void lexer_set_error(Lexer *lex, const char *msg) {
-    if (lex->error) free(lex->error);
-    lex->error = strdup(msg);
-    lex->error_line = lex->line;
-    lex->error_col = lex->col;
+    lex->error = msg;
+    lex->error_pos = lex->pos;
 }
 
-typedef struct {
-    size_t pos;
-    size_t line;
-    size_t col;
-    size_t line_start;
-    size_t token_start;
-    Token current;
-} Lexer_State;
+static bool lexer_push(Lexer *lex, Token_Type type, size_t start) {
+    if (lex->count >= lex->cap) {
+        size_t new_cap = lex->cap == 0 ? 256 : lex->cap * 2;
+        Token *new_tokens = realloc(lex->tokens, new_cap * sizeof(Token));
+        if (!new_tokens) {
+            lexer_set_error(lex, "out of memory");
+            return false;
+        }
+        lex->tokens = new_tokens;
+        lex->cap = new_cap;
+    }
+    Token *tok = &lex->tokens[lex->count++];
+    tok->type = type;
+    tok->start = (uint32_t)start;
+    tok->len = (uint32_t)(lex->pos - start);
+    tok->data.integer = 0;
+    return true;
+}
 
-static void lexer_save(Lexer *lex, Lexer_State *state) {
-    state->pos = lex->pos;
-    state->line = lex->line;
-    state->col = lex->col;
-    state->line_start = lex->line_start;
-    state->token_start = lex->token_start;
-    state->current = lex->current;
-    if (lex->current.type == TOK_STRING || lex->current.type == TOK_IDENT) {
-        state->current.data.string = strdup(lex->current.data.string);
+enum {
+    CC_SPACE = 1 << 0,
+    CC_DIGIT = 1 << 1,
+    CC_ALPHA = 1 << 2,
+};
+
+static const uint8_t char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, CC_SPACE, CC_SPACE, 0, 0, CC_SPACE, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    CC_SPACE, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    CC_DIGIT, CC_DIGIT, CC_DIGIT, CC_DIGIT, CC_DIGIT, CC_DIGIT, CC_DIGIT, CC_DIGIT,
+    CC_DIGIT, CC_DIGIT, 0, 0, 0, 0, 0, 0,
+    0, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA,
+    CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA,
+    CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA,
+    CC_ALPHA, CC_ALPHA, CC_ALPHA, 0, 0, 0, 0, CC_ALPHA,
+    0, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA,
+    CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA,
+    CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA, CC_ALPHA,
+    CC_ALPHA, CC_ALPHA, CC_ALPHA, 0, 0, 0, 0, 0,
+};
+
+#define char_is(c, cls) (char_class[(unsigned char)(c)] & (cls))
+
+static size_t scan_whitespace(const char *s, size_t pos, size_t len) {
+#ifdef SIMD_WIDTH
+    const Simd_Vec sp = simd_splat(' ');
+    const Simd_Vec tab = simd_splat('\t');
+    const Simd_Vec nl = simd_splat('\n');
+    const Simd_Vec cr = simd_splat('\r');
+    while (pos + SIMD_WIDTH <= len) {
+        Simd_Vec v = simd_load(s + pos);
+        Simd_Vec ws = simd_or(simd_or(simd_eq(v, sp), simd_eq(v, tab)),
+                              simd_or(simd_eq(v, nl), simd_eq(v, cr)));
+        uint32_t mask = simd_mask(ws) ^ SIMD_FULL_MASK;
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += SIMD_WIDTH;
     }
+#endif
+    while (pos < len && char_is(s[pos], CC_SPACE)) pos++;
+    return pos;
 }
 
-static void lexer_restore(Lexer *lex, Lexer_State *state) {
-    if (lex->current.type == TOK_STRING || lex->current.type == TOK_IDENT) {
-        free(lex->current.data.string);
+static size_t scan_ident(const char *s, size_t pos, size_t len) {
+#ifdef SIMD_WIDTH
+    const Simd_Vec lo_a = simd_splat('a' - 1), hi_z = simd_splat('z' + 1);
+    const Simd_Vec lo_A = simd_splat('A' - 1), hi_Z = simd_splat('Z' + 1);
+    const Simd_Vec lo_0 = simd_splat('0' - 1), hi_9 = simd_splat('9' + 1);
+    const Simd_Vec under = simd_splat('_');
+    while (pos + SIMD_WIDTH <= len) {
+        Simd_Vec v = simd_load(s + pos);
+        Simd_Vec lower = simd_and(simd_gt(v, lo_a), simd_gt(hi_z, v));
+        Simd_Vec upper = simd_and(simd_gt(v, lo_A), simd_gt(hi_Z, v));
+        Simd_Vec digit = simd_and(simd_gt(v, lo_0), simd_gt(hi_9, v));
+        Simd_Vec ok = simd_or(simd_or(lower, upper), simd_or(digit, simd_eq(v, under)));
+        uint32_t mask = simd_mask(ok) ^ SIMD_FULL_MASK;
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += SIMD_WIDTH;
     }
-    lex->pos = state->pos;
-    lex->line = state->line;
-    lex->col = state->col;
-    lex->line_start = state->line_start;
-    lex->token_start = state->token_start;
-    lex->current = state->current;
+#endif
+    while (pos < len && char_is(s[pos], CC_ALPHA | CC_DIGIT)) pos++;
+    return pos;
 }
 
-static void lexer_state_free(Lexer_State *state) {
-    if (state->current.type == TOK_STRING || state->current.type == TOK_IDENT) {
-        free(state->current.data.string);
-        state->current.data.string = NULL;
+static size_t scan_string(const char *s, size_t pos, size_t len) {
+#ifdef SIMD_WIDTH
+    const Simd_Vec quote = simd_splat('"');
+    const Simd_Vec backslash = simd_splat('\\');
+    while (pos + SIMD_WIDTH <= len) {
+        Simd_Vec v = simd_load(s + pos);
+        uint32_t mask = simd_mask(simd_or(simd_eq(v, quote), simd_eq(v, backslash))) | simd_mask(v);
+        if (mask) return pos + __builtin_ctz(mask);
+        pos += SIMD_WIDTH;
+    }
+#endif
+    while (pos < len) {
+        unsigned char c = (unsigned char)s[pos];
+        if (c == '"' || c == '\\' || c >= 0x80) break;
+        pos++;
     }
+    return pos;
 }
 
-static void lexer_advance(Lexer *lex) {
-    if (lex->pos < lex->len) {
-        if (lex->src[lex->pos] == '\n') {
-            lex->line++;
-            lex->col = 1;
-            lex->pos++;
-            lex->line_start = lex->pos;
-        } else {
-            lex->col++;
-            lex->pos++;
-        }
+static size_t scan_comment_end(const char *s, size_t pos, size_t len) {
+    while (pos < len) {
+        const char *star = memchr(s + pos, '*', len - pos);
+        if (!star) break;
+        pos = star - s + 1;
+        if (pos < len && s[pos] == '/') return pos + 1;
     }
+    return SIZE_MAX;
 }
 
-static void lexer_skip_whitespace(Lexer *lex) {
-    while (lex->pos < lex->len) {
-        char c = lex->src[lex->pos];
-        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-            lexer_advance(lex);
-        } else if (c == '/' && lex->pos + 1 < lex->len && lex->src[lex->pos + 1] == '/') {
-            lexer_advance(lex);
-            lexer_advance(lex);
-            while (lex->pos < lex->len && lex->src[lex->pos] != '\n') {
-                lexer_advance(lex);
-            }
-        } else if (c == '/' && lex->pos + 1 < lex->len && lex->src[lex->pos + 1] == '*') {
-            lexer_advance(lex);
-            lexer_advance(lex);
-            while (lex->pos + 1 < lex->len) {
-                if (lex->src[lex->pos] == '*' && lex->src[lex->pos + 1] == '/') {
-                    lexer_advance(lex);
-                    lexer_advance(lex);
-                    break;
-                }
-                lexer_advance(lex);
+static size_t utf8_sequence_length(const unsigned char *s, size_t avail) {
+    unsigned char c = s[0];
+    if (c < 0x80) return 1;
+    if (c < 0xC2) return 0;
+    if (c < 0xE0) {
+        if (avail < 2 || (s[1] & 0xC0) != 0x80) return 0;
+        return 2;
+    }
+    if (c < 0xF0) {
+        if (avail < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+        if (c == 0xE0 && s[1] < 0xA0) return 0;
+        if (c == 0xED && s[1] >= 0xA0) return 0;
+        return 3;
+    }
+    if (c < 0xF5) {
+        if (avail < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80) return 0;
+        if (c == 0xF0 && s[1] < 0x90) return 0;
+        if (c == 0xF4 && s[1] >= 0x90) return 0;
+        return 4;
+    }
+    return 0;
+}
+
+static bool lexer_skip_whitespace(Lexer *lex) {
+    const char *s = lex->src;
+    size_t len = lex->len;
+    size_t pos = lex->pos;
+
+    for (;;) {
+        pos = scan_whitespace(s, pos, len);
+        if (pos + 1 >= len || s[pos] != '/') break;
+        if (s[pos + 1] == '/') {
+            const char *nl = memchr(s + pos + 2, '\n', len - pos - 2);
+            pos = nl ? (size_t)(nl - s) : len;
+        } else if (s[pos + 1] == '*') {
+            size_t end = scan_comment_end(s, pos + 2, len);
+            if (end == SIZE_MAX) {
+                lex->pos = pos;
+                lexer_set_error(lex, "unterminated comment");
+                return false;
             }
+            pos = end;
         } else {
             break;
         }
     }
-}
-
-static bool is_ident_start(char c) {
-    return isalpha(c) || c == '_';
-}
 
-static bool is_ident_char(char c) {
-    return isalnum(c) || c == '_';
+    lex->pos = pos;
+    return true;
 }
 
 static char *strdup_range(const char *start, size_t len) {
@@ -177,1086 +503,4431 @@ static char *strdup_range(const char *start, size_t len) {
     return s;
 }
 
-static bool lexer_next(Lexer *lex) {
-    if (lex->current.type == TOK_STRING || lex->current.type == TOK_IDENT) {
-        free(lex->current.data.string);
-        lex->current.data.string = NULL;
-    }
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} String_Builder;
 
-    lexer_skip_whitespace(lex);
-    lex->token_start = lex->pos;
+static void sb_init(String_Builder *sb) {
+    sb->buf = malloc(256);
+    sb->len = 0;
+    sb->cap = 256;
+    if (sb->buf) sb->buf[0] = '\0';
+}
 
-    if (lex->pos >= lex->len) {
-        lex->current.type = TOK_EOF;
-        return true;
+static void sb_append_len(String_Builder *sb, const char *str, size_t add_len) {
+    if (!sb->buf) return;
+    if (sb->len + add_len + 1 > sb->cap) {
+        size_t new_cap = sb->cap;
+        while (sb->len + add_len + 1 > new_cap) new_cap *= 2;
+        char *new_buf = realloc(sb->buf, new_cap);
+        if (!new_buf) {
+            free(sb->buf);
+            sb->buf = NULL;
+            return;
+        }
+        sb->buf = new_buf;
+        sb->cap = new_cap;
     }
+    memcpy(sb->buf + sb->len, str, add_len);
+    sb->len += add_len;
+    sb->buf[sb->len] = '\0';
+}
 
-    char c = lex->src[lex->pos];
+static void sb_append(String_Builder *sb, const char *str) {
+    sb_append_len(sb, str, strlen(str));
+}
 
-    if (c == '{') { lex->current.type = TOK_LBRACE; lexer_advance(lex); return true; }
-    if (c == '}') { lex->current.type = TOK_RBRACE; lexer_advance(lex); return true; }
-    if (c == '[') { lex->current.type = TOK_LBRACKET; lexer_advance(lex); return true; }
-    if (c == ']') { lex->current.type = TOK_RBRACKET; lexer_advance(lex); return true; }
-    if (c == '(') { lex->current.type = TOK_LPAREN; lexer_advance(lex); return true; }
-    if (c == ')') { lex->current.type = TOK_RPAREN; lexer_advance(lex); return true; }
-    if (c == ';') { lex->current.type = TOK_SEMICOLON; lexer_advance(lex); return true; }
-    if (c == ',') { lex->current.type = TOK_COMMA; lexer_advance(lex); return true; }
-    if (c == '=' && lex->pos + 1 < lex->len && lex->src[lex->pos + 1] == '>') {
-        lex->current.type = TOK_ARROW;
-        lexer_advance(lex);
-        lexer_advance(lex);
-        return true;
+static void sb_append_char(String_Builder *sb, char c) {
+    sb_append_len(sb, &c, 1);
+}
+
+static Token_Type keyword_type(const char *s, size_t len) {
+    switch (len) {
+        case 2:
+            if (s[0] == 'i' && s[1] == 'f') return TOK_IF;
+            break;
+        case 3:
+            if (s[0] == 'l' && s[1] == 'e' && s[2] == 't') return TOK_LET;
+            break;
+        case 4:
+            switch (s[0]) {
+                case 't':
+                    if (memcmp(s, "true", 4) == 0) return TOK_TRUE;
+                    if (memcmp(s, "then", 4) == 0) return TOK_THEN;
+                    break;
+                case 'e':
+                    if (memcmp(s, "else", 4) == 0) return TOK_ELSE;
+                    break;
+            }
+            break;
+        case 5:
+            if (memcmp(s, "false", 5) == 0) return TOK_FALSE;
+            break;
+        case 6:
+            if (memcmp(s, "import", 6) == 0) return TOK_IMPORT;
+            break;
     }
-    if (c == '=') { lex->current.type = TOK_EQUALS; lexer_advance(lex); return true; }
-    if (c == ':') { lex->current.type = TOK_COLON; lexer_advance(lex); return true; }
-    if (c == '?') { lex->current.type = TOK_QUESTION; lexer_advance(lex); return true; }
+    return TOK_IDENT;
+}
 
-    if (c == '.' && lex->pos + 2 < lex->len &&
-        lex->src[lex->pos + 1] == '.' && lex->src[lex->pos + 2] == '.') {
-        lex->current.type = TOK_SPREAD;
-        lexer_advance(lex);
-        lexer_advance(lex);
-        lexer_advance(lex);
-        return true;
+static bool lexer_next(Lexer *lex) {
+    if (!lexer_skip_whitespace(lex)) return false;
+    size_t start = lex->pos;
+
+    if (lex->pos >= lex->len) {
+        return lexer_push(lex, TOK_EOF, start);
     }
 
-    if (c == '.' && lex->pos + 1 < lex->len && lex->src[lex->pos + 1] == '.') {
-        lex->current.type = TOK_DOTDOT;
-        lexer_advance(lex);
-        lexer_advance(lex);
-        return true;
+    char c = lex->src[lex->pos];
+    Token_Type type;
+
+    switch (c) {
+        case '{': type = TOK_LBRACE; break;
+        case '}': type = TOK_RBRACE; break;
+        case '[': type = TOK_LBRACKET; break;
+        case ']': type = TOK_RBRACKET; break;
+        case '(': type = TOK_LPAREN; break;
+        case ')': type = TOK_RPAREN; break;
+        case ';': type = TOK_SEMICOLON; break;
+        case ',': type = TOK_COMMA; break;
+        case ':': type = TOK_COLON; break;
+        case '?': type = TOK_QUESTION; break;
+        case '=':
+            if (lex->pos + 1 < lex->len && lex->src[lex->pos + 1] == '>') {
+                lex->pos += 2;
+                return lexer_push(lex, TOK_ARROW, start);
+            }
+            type = TOK_EQUALS;
+            break;
+        case '.':
+            if (lex->pos + 2 < lex->len &&
+                lex->src[lex->pos + 1] == '.' && lex->src[lex->pos + 2] == '.') {
+                lex->pos += 3;
+                return lexer_push(lex, TOK_SPREAD, start);
+            }
+            if (lex->pos + 1 < lex->len && lex->src[lex->pos + 1] == '.') {
+                lex->pos += 2;
+                return lexer_push(lex, TOK_DOTDOT, start);
+            }
+            type = TOK_DOT;
+            break;
+        default:
+            type = TOK_EOF;
+            break;
     }
 
-    if (c == '.') {
-        lex->current.type = TOK_DOT;
-        lexer_advance(lex);
-        return true;
+    if (type != TOK_EOF) {
+        lex->pos++;
+        return lexer_push(lex, type, start);
     }
 
     if (c == '"') {
-        lexer_advance(lex);
-        size_t buf_size = 256;
-        size_t buf_len = 0;
-        char *buf = malloc(buf_size);
-        if (!buf) return false;
-
-        while (lex->pos < lex->len && lex->src[lex->pos] != '"') {
-            char ch = lex->src[lex->pos];
-            if (ch == '\\' && lex->pos + 1 < lex->len) {
-                lexer_advance(lex);
-                ch = lex->src[lex->pos];
-                switch (ch) {
-                    case 'n': ch = '\n'; break;
-                    case 't': ch = '\t'; break;
-                    case 'r': ch = '\r'; break;
-                    case '\\': ch = '\\'; break;
-                    case '"': ch = '"'; break;
-                    case '$': ch = '$'; break;
-                    default: break;
-                }
+        const char *s = lex->src;
+        size_t len = lex->len;
+        size_t pos = lex->pos + 1;
+
+        for (;;) {
+            pos = scan_string(s, pos, len);
+            if (pos >= len) break;
+            unsigned char ch = (unsigned char)s[pos];
+            if (ch == '"') break;
+            if (ch == '\\') {
+                pos++;
+                if (pos < len && (unsigned char)s[pos] < 0x80) pos++;
+                continue;
             }
-            if (buf_len + 1 >= buf_size) {
-                buf_size *= 2;
-                buf = realloc(buf, buf_size);
-                if (!buf) return false;
+            size_t n = utf8_sequence_length((const unsigned char *)s + pos, len - pos);
+            if (n == 0) {
+                lex->pos = pos;
+                lexer_set_error(lex, "invalid utf-8 in string");
+                return false;
             }
-            buf[buf_len++] = ch;
-            lexer_advance(lex);
+            pos += n;
         }
 
+        lex->pos = pos;
         if (lex->pos >= lex->len) {
-            free(buf);
             lexer_set_error(lex, "unterminated string");
             return false;
         }
 
-        lexer_advance(lex);
-        buf[buf_len] = '\0';
-        lex->current.type = TOK_STRING;
-        lex->current.data.string = buf;
-        return true;
+        lex->pos++;
+        return lexer_push(lex, TOK_STRING, start);
     }
 
-    if (isdigit(c) || (c == '-' && lex->pos + 1 < lex->len && isdigit(lex->src[lex->pos + 1]))) {
+    if (char_is(c, CC_DIGIT) || (c == '-' && lex->pos + 1 < lex->len && char_is(lex->src[lex->pos + 1], CC_DIGIT))) {
         int sign = 1;
         if (c == '-') {
             sign = -1;
-            lexer_advance(lex);
+            lex->pos++;
         }
         int64_t val = 0;
-        while (lex->pos < lex->len && isdigit(lex->src[lex->pos])) {
+        while (lex->pos < lex->len && char_is(lex->src[lex->pos], CC_DIGIT)) {
             val = val * 10 + (lex->src[lex->pos] - '0');
-            lexer_advance(lex);
+            lex->pos++;
         }
-        lex->current.type = TOK_INT;
-        lex->current.data.integer = val * sign;
+        if (!lexer_push(lex, TOK_INT, start)) return false;
+        lex->tokens[lex->count - 1].data.integer = val * sign;
         return true;
     }
 
-    if (is_ident_start(c)) {
-        size_t start = lex->pos;
-        while (lex->pos < lex->len && is_ident_char(lex->src[lex->pos])) {
-            lexer_advance(lex);
+    if (char_is(c, CC_ALPHA)) {
+        lex->pos = scan_ident(lex->src, lex->pos + 1, lex->len);
+        Token_Type type = keyword_type(lex->src + start, lex->pos - start);
+        if (!lexer_push(lex, type, start)) return false;
+        if (type == TOK_IDENT && !lex->symbols) {
+            lex->tokens[lex->count - 1].data.hash = hash_bytes(lex->src + start, lex->pos - start);
+        } else if (type == TOK_IDENT) {
+            const Goon_Symbol *sym = symtab_intern(lex->symbols, lex->src + start, lex->pos - start);
+            if (!sym) {
+                lexer_set_error(lex, "out of memory");
+                return false;
+            }
+            lex->tokens[lex->count - 1].data.sym = sym;
         }
-        char *ident = strdup_range(lex->src + start, lex->pos - start);
+        return true;
+    }
 
-        if (strcmp(ident, "true") == 0) {
-            free(ident);
-            lex->current.type = TOK_TRUE;
-            return true;
-        }
-        if (strcmp(ident, "false") == 0) {
-            free(ident);
-            lex->current.type = TOK_FALSE;
-            return true;
-        }
-        if (strcmp(ident, "let") == 0) {
-            free(ident);
-            lex->current.type = TOK_LET;
-            return true;
-        }
-        if (strcmp(ident, "if") == 0) {
-            free(ident);
-            lex->current.type = TOK_IF;
-            return true;
-        }
-        if (strcmp(ident, "then") == 0) {
-            free(ident);
-            lex->current.type = TOK_THEN;
-            return true;
-        }
-        if (strcmp(ident, "else") == 0) {
-            free(ident);
-            lex->current.type = TOK_ELSE;
-            return true;
+    lexer_set_error(lex, "unexpected character");
+    return false;
+}
+
+static bool lexer_run(Lexer *lex) {
+    do {
+        if (!lexer_next(lex)) return false;
+    } while (lex->tokens[lex->count - 1].type != TOK_EOF);
+    return true;
+}
+
+static bool lexer_bind(Lexer *lex, Goon_Symtab *symbols) {
+    for (size_t i = 0; i < lex->count; i++) {
+        Token *tok = &lex->tokens[i];
+        if (tok->type != TOK_IDENT) continue;
+        const Goon_Symbol *sym = symtab_intern_hash(symbols, lex->src + tok->start, tok->len, tok->data.hash);
+        if (!sym) {
+            lex->error = "out of memory";
+            lex->error_pos = tok->start;
+            return false;
         }
-        if (strcmp(ident, "import") == 0) {
-            free(ident);
-            lex->current.type = TOK_IMPORT;
-            return true;
+        tok->data.sym = sym;
+    }
+    lex->symbols = symbols;
+    return true;
+}
+
+static char *token_string(const Goon_Source *src, const Token *tok) {
+    const char *s = src->text + tok->start + 1;
+    size_t len = tok->len - 2;
+    char *buf = malloc(len + 1);
+    if (!buf) return NULL;
+
+    size_t buf_len = 0;
+    for (size_t i = 0; i < len; i++) {
+        char ch = s[i];
+        if (ch == '\\' && i + 1 < len) {
+            ch = s[++i];
+            switch (ch) {
+                case 'n': ch = '\n'; break;
+                case 't': ch = '\t'; break;
+                case 'r': ch = '\r'; break;
+                default: break;
+            }
         }
+        buf[buf_len++] = ch;
+    }
+    buf[buf_len] = '\0';
+    return buf;
+}
 
-        lex->current.type = TOK_IDENT;
-        lex->current.data.string = ident;
-        return true;
+#define VALUE_NIL ((Goon_Value *)(uintptr_t)0x2)
+#define VALUE_FALSE ((Goon_Value *)(uintptr_t)0x6)
+#define VALUE_TRUE ((Goon_Value *)(uintptr_t)0xa)
+
+#define GOON_THUNK ((Goon_Type)GOON_TYPE_COUNT)
+#define GOON_SEQ ((Goon_Type)(GOON_TYPE_COUNT + 1))
+
+static bool is_heap(Goon_Value *val) {
+    return val != NULL && ((uintptr_t)val & 7) == 0;
+}
+
+static Goon_Type value_type(Goon_Value *val) {
+    if (is_heap(val)) return val->type;
+    if ((uintptr_t)val & 1) return GOON_INT;
+    if (val == VALUE_TRUE || val == VALUE_FALSE) return GOON_BOOL;
+    return GOON_NIL;
+}
+
+static Goon_Value *force(Goon_Value *val);
+
+Goon_Type goon_type(Goon_Value *val) {
+    Goon_Type type = value_type(val);
+    if (type == GOON_THUNK) type = value_type(force(val));
+    return type == GOON_SEQ ? GOON_LIST : type;
+}
+
+const char *goon_type_name(Goon_Type type) {
+    static const char *names[GOON_TYPE_COUNT] = {
+        [GOON_NIL] = "nil",
+        [GOON_BOOL] = "bool",
+        [GOON_INT] = "int",
+        [GOON_STRING] = "string",
+        [GOON_LIST] = "list",
+        [GOON_RECORD] = "record",
+        [GOON_BUILTIN] = "builtin",
+        [GOON_LAMBDA] = "lambda",
+    };
+    return (unsigned)type < GOON_TYPE_COUNT ? names[type] : "unknown";
+}
+
+static int64_t int_value(Goon_Value *val) {
+    if ((uintptr_t)val & 1) return (int64_t)((intptr_t)val >> 1);
+    return val->data.integer;
+}
+
+static void *ctx_alloc(Goon_Ctx *ctx, size_t size) {
+    void *mem = arena_alloc(ctx->scratch_on ? ctx->scratch : ctx->arena, size);
+    if (mem) ctx->stats.bytes_allocated += size;
+    return mem;
+}
+
+static pthread_mutex_t *shared_lock(Goon_Ctx *ctx);
+
+static bool scratch_free(Goon_Ctx *ctx) {
+    return !ctx->parent && !ctx->scratch_busy && !shared_lock(ctx);
+}
+
+static bool scratch_begin(Goon_Ctx *ctx) {
+    if (!scratch_free(ctx)) return false;
+    if (!ctx->scratch) {
+        ctx->scratch = calloc(1, sizeof(Arena));
+        if (!ctx->scratch) return false;
+        ctx->scratch->owner = ctx;
     }
+    ctx->scratch_busy = true;
+    ctx->scratch_on = true;
+    return true;
+}
 
-    lexer_set_error(lex, "unexpected character");
-    return false;
+static void scratch_end(Goon_Ctx *ctx) {
+    ctx->scratch_on = false;
+    ctx->scratch_busy = false;
+    arena_reset(ctx->scratch);
+}
+
+static bool scratch_pause(Goon_Ctx *ctx, const void *owner) {
+    if (!ctx->scratch_on || (owner && arena_owns(ctx->scratch, owner))) return false;
+    ctx->scratch_on = false;
+    return true;
+}
+
+static void scratch_resume(Goon_Ctx *ctx, bool paused) {
+    if (paused) ctx->scratch_on = true;
 }
 
-static Goon_Value *alloc_value(Goon_Ctx *ctx) {
-    Goon_Value *val = malloc(sizeof(Goon_Value));
+static Goon_Value *alloc_value_extra(Goon_Ctx *ctx, Goon_Type type, size_t extra) {
+    Goon_Value *val = ctx_alloc(ctx, sizeof(Goon_Value) + extra);
     if (!val) return NULL;
-    val->type = GOON_NIL;
-    val->next_alloc = ctx->values;
-    ctx->values = val;
+    val->type = type;
+    val->frozen = false;
+    if (type == GOON_THUNK) {
+        ctx->stats.thunks++;
+    } else {
+        ctx->stats.values[type == GOON_SEQ ? GOON_LIST : type]++;
+    }
     return val;
 }
 
-static Goon_Record_Field *alloc_field(Goon_Ctx *ctx) {
-    Goon_Record_Field *field = malloc(sizeof(Goon_Record_Field));
-    if (!field) return NULL;
-    field->key = NULL;
-    field->value = NULL;
-    field->next = ctx->fields;
-    ctx->fields = field;
-    return field;
+static Goon_Value *alloc_value(Goon_Ctx *ctx, Goon_Type type) {
+    return alloc_value_extra(ctx, type, 0);
 }
 
 Goon_Value *goon_nil(Goon_Ctx *ctx) {
-    Goon_Value *val = alloc_value(ctx);
-    if (!val) return NULL;
-    val->type = GOON_NIL;
-    return val;
+    (void)ctx;
+    return VALUE_NIL;
 }
 
 Goon_Value *goon_bool(Goon_Ctx *ctx, bool b) {
-    Goon_Value *val = alloc_value(ctx);
-    if (!val) return NULL;
-    val->type = GOON_BOOL;
-    val->data.boolean = b;
-    return val;
+    (void)ctx;
+    return b ? VALUE_TRUE : VALUE_FALSE;
 }
 
 Goon_Value *goon_int(Goon_Ctx *ctx, int64_t i) {
-    Goon_Value *val = alloc_value(ctx);
+    if (i >= INTPTR_MIN / 2 && i <= INTPTR_MAX / 2) {
+        return (Goon_Value *)(((uintptr_t)(intptr_t)i << 1) | 1);
+    }
+    Goon_Value *val = alloc_value(ctx, GOON_INT);
     if (!val) return NULL;
-    val->type = GOON_INT;
     val->data.integer = i;
     return val;
 }
 
-Goon_Value *goon_string(Goon_Ctx *ctx, const char *s) {
-    Goon_Value *val = alloc_value(ctx);
+static Goon_Ctx *home_ctx(Goon_Ctx *ctx) {
+    return ctx->parent ? ctx->parent : ctx;
+}
+
+static Goon_Value *string_value(Goon_Ctx *ctx, const char *s, size_t len, bool terminated) {
+    Goon_Value *val = alloc_value(ctx, GOON_STRING);
     if (!val) return NULL;
-    val->type = GOON_STRING;
-    val->data.string = strdup(s);
+    val->data.string.ptr = s;
+    val->data.string.len = len;
+    val->data.string.ctx = home_ctx(ctx);
+    val->data.string.flat = NULL;
+    val->data.string.terminated = terminated;
     return val;
 }
 
+Goon_Value *goon_string_len(Goon_Ctx *ctx, const char *s, size_t len) {
+    Goon_Value *val = alloc_value_extra(ctx, GOON_STRING, len + 1);
+    if (!val) return NULL;
+    ctx->stats.string_bytes += len + 1;
+    char *buf = (char *)(val + 1);
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    val->data.string.ptr = buf;
+    val->data.string.len = len;
+    val->data.string.ctx = home_ctx(ctx);
+    val->data.string.terminated = true;
+    return val;
+}
+
+Goon_Value *goon_string(Goon_Ctx *ctx, const char *s) {
+    return goon_string_len(ctx, s, strlen(s));
+}
+
+Goon_Value *goon_string_static(Goon_Ctx *ctx, const char *s) {
+    return string_value(ctx, s, strlen(s), true);
+}
+
+enum { LIST_UNKNOWN, LIST_INTS, LIST_STRINGS, LIST_MIXED };
+
+static uint8_t elem_kind(Goon_Value *item) {
+    Goon_Type type = value_type(item);
+    if (type == GOON_INT) return LIST_INTS;
+    if (type == GOON_STRING) return LIST_STRINGS;
+    return type == GOON_THUNK ? LIST_UNKNOWN : LIST_MIXED;
+}
+
+static uint8_t kind_merge(uint8_t a, uint8_t b) {
+    if (a == b) return a;
+    if (a == LIST_MIXED || b == LIST_MIXED) return LIST_MIXED;
+    if (a == LIST_UNKNOWN || b == LIST_UNKNOWN) return LIST_UNKNOWN;
+    return LIST_MIXED;
+}
+
+static void list_note(Goon_Value *list, size_t before, uint8_t kind) {
+    list->data.list.packed = NULL;
+    list->data.list.kind = before == 0 ? kind : kind_merge(list->data.list.kind, kind);
+}
+
+static uint8_t list_kind(Goon_Value *list) {
+    size_t len = list->data.list.len;
+    if (list->data.list.kind != LIST_UNKNOWN || len == 0) return list->data.list.kind;
+    Goon_Value **items = list->data.list.items;
+    uint8_t kind = elem_kind(items[0]);
+    for (size_t i = 1; i < len && kind != LIST_MIXED; i++) {
+        kind = kind_merge(kind, elem_kind(items[i]));
+    }
+    list->data.list.kind = kind;
+    return kind;
+}
+
 Goon_Value *goon_list(Goon_Ctx *ctx) {
-    Goon_Value *val = alloc_value(ctx);
+    Goon_Value *val = alloc_value(ctx, GOON_LIST);
     if (!val) return NULL;
-    val->type = GOON_LIST;
     val->data.list.items = NULL;
     val->data.list.len = 0;
     val->data.list.cap = 0;
+    val->data.list.ctx = home_ctx(ctx);
+    val->data.list.packed = NULL;
+    val->data.list.kind = LIST_UNKNOWN;
     return val;
 }
 
 Goon_Value *goon_record(Goon_Ctx *ctx) {
-    Goon_Value *val = alloc_value(ctx);
-    if (!val) return NULL;
-    val->type = GOON_RECORD;
-    val->data.record.fields = NULL;
-    return val;
-}
-
-static Goon_Value *goon_lambda(Goon_Ctx *ctx, char **params, size_t param_count, const char *body, Goon_Binding *env) {
-    Goon_Value *val = alloc_value(ctx);
+    Goon_Value *val = alloc_value(ctx, GOON_RECORD);
     if (!val) return NULL;
-    val->type = GOON_LAMBDA;
-    val->data.lambda.params = malloc(param_count * sizeof(char *));
-    if (!val->data.lambda.params && param_count > 0) return NULL;
-    for (size_t i = 0; i < param_count; i++) {
-        val->data.lambda.params[i] = strdup(params[i]);
-    }
-    val->data.lambda.param_count = param_count;
-    val->data.lambda.body = strdup(body);
-    val->data.lambda.env = env;
+    val->data.record.shape = ctx->empty_shape;
+    val->data.record.values = NULL;
+    val->data.record.cap = 0;
+    val->data.record.parent = NULL;
+    val->data.record.size = 0;
+    val->data.record.depth = 0;
     return val;
 }
 
 bool goon_is_nil(Goon_Value *val) {
-    return val == NULL || val->type == GOON_NIL;
+    return value_type(val) == GOON_NIL;
 }
 
 bool goon_is_bool(Goon_Value *val) {
-    return val != NULL && val->type == GOON_BOOL;
+    return value_type(val) == GOON_BOOL;
 }
 
 bool goon_is_int(Goon_Value *val) {
-    return val != NULL && val->type == GOON_INT;
+    return value_type(val) == GOON_INT;
 }
 
 bool goon_is_string(Goon_Value *val) {
-    return val != NULL && val->type == GOON_STRING;
+    return value_type(val) == GOON_STRING;
 }
 
 bool goon_is_list(Goon_Value *val) {
-    return val != NULL && val->type == GOON_LIST;
+    Goon_Type type = value_type(val);
+    return type == GOON_LIST || type == GOON_SEQ;
 }
 
 bool goon_is_record(Goon_Value *val) {
-    return val != NULL && val->type == GOON_RECORD;
+    return value_type(val) == GOON_RECORD;
 }
 
 bool goon_to_bool(Goon_Value *val) {
-    if (val == NULL) return false;
-    if (val->type == GOON_BOOL) return val->data.boolean;
-    if (val->type == GOON_NIL) return false;
-    return true;
+    return val != NULL && val != VALUE_NIL && val != VALUE_FALSE;
 }
 
 int64_t goon_to_int(Goon_Value *val) {
-    if (val == NULL || val->type != GOON_INT) return 0;
-    return val->data.integer;
+    if (value_type(val) != GOON_INT) return 0;
+    return int_value(val);
 }
 
 const char *goon_to_string(Goon_Value *val) {
-    if (val == NULL || val->type != GOON_STRING) return NULL;
-    return val->data.string;
+    if (value_type(val) != GOON_STRING) return NULL;
+    if (val->data.string.terminated) return val->data.string.ptr;
+
+    size_t len = val->data.string.len;
+    Goon_Ctx *ctx = val->data.string.ctx;
+    pthread_mutex_t *lock = shared_lock(ctx);
+    if (lock) pthread_mutex_lock(lock);
+    char *copy = (char *)val->data.string.flat;
+    if (!copy) {
+        bool paused = scratch_pause(ctx, val);
+        copy = ctx_alloc(ctx, len + 1);
+        scratch_resume(ctx, paused);
+        if (copy) {
+            ctx->stats.string_bytes += len + 1;
+            memcpy(copy, val->data.string.ptr, len);
+            copy[len] = '\0';
+            val->data.string.flat = copy;
+        }
+    }
+    if (copy && !lock) {
+        val->data.string.ptr = copy;
+        val->data.string.terminated = true;
+    }
+    if (lock) pthread_mutex_unlock(lock);
+    return copy;
 }
 
-void goon_list_push(Goon_Ctx *ctx, Goon_Value *list, Goon_Value *item) {
-    (void)ctx;
-    if (!list || list->type != GOON_LIST) return;
-    if (list->data.list.len >= list->data.list.cap) {
-        size_t new_cap = list->data.list.cap == 0 ? 8 : list->data.list.cap * 2;
-        Goon_Value **new_items = realloc(list->data.list.items, new_cap * sizeof(Goon_Value *));
-        if (!new_items) return;
-        list->data.list.items = new_items;
-        list->data.list.cap = new_cap;
+Goon_Str goon_to_str(Goon_Value *val) {
+    Goon_Str str = { NULL, 0 };
+    if (value_type(val) != GOON_STRING) return str;
+    str.ptr = val->data.string.ptr;
+    str.len = val->data.string.len;
+    return str;
+}
+
+static bool list_reserve(Goon_Ctx *ctx, Goon_Value *list, size_t need) {
+    if (need <= list->data.list.cap) return true;
+    size_t new_cap = list->data.list.cap == 0 ? 8 : list->data.list.cap * 2;
+    while (new_cap < need) new_cap *= 2;
+    Goon_Value **new_items = ctx_alloc(ctx, new_cap * sizeof(Goon_Value *));
+    if (!new_items) return false;
+    if (list->data.list.len > 0) {
+        memcpy(new_items, list->data.list.items, list->data.list.len * sizeof(Goon_Value *));
     }
+    list->data.list.items = new_items;
+    list->data.list.cap = new_cap;
+    return true;
+}
+
+static Goon_Value *list_sized(Goon_Ctx *ctx, size_t cap) {
+    Goon_Value *list = goon_list(ctx);
+    if (!list || cap == 0) return list;
+    list->data.list.items = ctx_alloc(ctx, cap * sizeof(Goon_Value *));
+    if (!list->data.list.items) return NULL;
+    list->data.list.cap = cap;
+    return list;
+}
+
+void goon_list_push(Goon_Ctx *ctx, Goon_Value *list, Goon_Value *item) {
+    if (value_type(list) != GOON_LIST || list->frozen) return;
+    if (!list_reserve(ctx, list, list->data.list.len + 1)) return;
+    list_note(list, list->data.list.len, elem_kind(item));
     list->data.list.items[list->data.list.len++] = item;
 }
 
 size_t goon_list_len(Goon_Value *list) {
-    if (!list || list->type != GOON_LIST) return 0;
+    Goon_Type type = value_type(list);
+    if (type == GOON_SEQ) return list->data.seq.len;
+    if (type != GOON_LIST) return 0;
     return list->data.list.len;
 }
 
-Goon_Value *goon_list_get(Goon_Value *list, size_t index) {
-    if (!list || list->type != GOON_LIST) return NULL;
-    if (index >= list->data.list.len) return NULL;
-    return list->data.list.items[index];
-}
+static Goon_Value *call_value(Goon_Ctx *ctx, Goon_Value *fn, Goon_Value **args, size_t argc);
 
-void goon_record_set(Goon_Ctx *ctx, Goon_Value *record, const char *key, Goon_Value *value) {
-    if (!record || record->type != GOON_RECORD) return;
+#define LIST_VIEW_MIN 64
+#define LIST_MAX_PARTS 16
 
-    Goon_Record_Field *f = record->data.record.fields;
-    while (f) {
-        if (strcmp(f->key, key) == 0) {
-            f->value = value;
-            return;
-        }
-        f = f->next;
-    }
+struct Goon_List_Part {
+    Goon_Value *list;
+    size_t start;
+    size_t end;
+};
 
-    Goon_Record_Field *field = alloc_field(ctx);
-    if (!field) return;
-    field->key = strdup(key);
-    field->value = value;
-    field->next = record->data.record.fields;
-    record->data.record.fields = field;
+static size_t range_len(int64_t start, int64_t end, int64_t step) {
+    uint64_t span;
+    if (step > 0 && end >= start) {
+        span = ((uint64_t)end - (uint64_t)start) / (uint64_t)step;
+    } else if (step < 0 && end <= start) {
+        span = ((uint64_t)start - (uint64_t)end) / (0 - (uint64_t)step);
+    } else {
+        return 0;
+    }
+    return span >= SIZE_MAX ? SIZE_MAX : (size_t)span + 1;
 }
 
-Goon_Value *goon_record_get(Goon_Value *record, const char *key) {
-    if (!record || record->type != GOON_RECORD) return NULL;
-    Goon_Record_Field *f = record->data.record.fields;
-    while (f) {
-        if (strcmp(f->key, key) == 0) {
-            return f->value;
-        }
-        f = f->next;
-    }
-    return NULL;
+static Goon_Value *seq_range(Goon_Ctx *ctx, int64_t start, int64_t end, int64_t step) {
+    Goon_Value *val = alloc_value(ctx, GOON_SEQ);
+    if (!val) return NULL;
+    val->data.seq.source = NULL;
+    val->data.seq.fn = NULL;
+    val->data.seq.start = start;
+    val->data.seq.step = step;
+    val->data.seq.len = range_len(start, end, step);
+    val->data.seq.ctx = home_ctx(ctx);
+    val->data.seq.parts = NULL;
+    val->data.seq.part_count = 0;
+    return val;
 }
 
-static void goon_record_set_path(Goon_Ctx *ctx, Goon_Value *record, char **path, size_t path_len, Goon_Value *value) {
+static Goon_Value *seq_map(Goon_Ctx *ctx, Goon_Value *source, Goon_Value *fn) {
+    Goon_Value *val = alloc_value(ctx, GOON_SEQ);
+    if (!val) return NULL;
+    val->data.seq.source = source;
+    val->data.seq.fn = fn;
+    val->data.seq.start = 0;
+    val->data.seq.step = 0;
+    val->data.seq.len = goon_list_len(source);
+    val->data.seq.ctx = home_ctx(ctx);
+    val->data.seq.parts = NULL;
+    val->data.seq.part_count = 0;
+    return val;
+}
+
+static bool seq_is_range(Goon_Value *seq) {
+    return !seq->data.seq.source && !seq->data.seq.parts;
+}
+
+static bool seq_is_view(Goon_Value *seq) {
+    return value_type(seq) == GOON_SEQ && seq->data.seq.parts;
+}
+
+static int64_t seq_int(Goon_Value *seq, size_t index) {
+    return seq->data.seq.start + (int64_t)index * seq->data.seq.step;
+}
+
+static Goon_Value *list_read(Goon_Ctx *ctx, Goon_Value *list, size_t index, bool keep);
+
+static Goon_Value *list_get(Goon_Ctx *ctx, Goon_Value *list, size_t index) {
+    return list_read(ctx, list, index, false);
+}
+
+static bool seq_fill(Goon_Ctx *ctx, Goon_Value *seq) {
+    bool paused = scratch_pause(ctx, seq);
+    size_t len = seq->data.seq.len;
+    Goon_Value *list = list_sized(ctx, len);
+    Goon_List_Part *part = ctx_alloc(ctx, sizeof(Goon_List_Part));
+    for (size_t i = 0; list && part && i < len; i++) {
+        Goon_Value *item = list_get(ctx, seq->data.seq.source, i);
+        Goon_Value *args[1] = { item };
+        item = item ? force(call_value(ctx, seq->data.seq.fn, args, 1)) : NULL;
+        if (!item) list = NULL;
+        else list->data.list.items[list->data.list.len++] = item;
+    }
+    scratch_resume(ctx, paused);
+    if (!list || !part) return false;
+    part->list = list;
+    part->start = 0;
+    part->end = len;
+    seq->data.seq.source = NULL;
+    seq->data.seq.fn = NULL;
+    seq->data.seq.parts = part;
+    seq->data.seq.part_count = 1;
+    return true;
+}
+
+static Goon_Value *seq_get(Goon_Ctx *ctx, Goon_Value *seq, size_t index, bool keep);
+
+static bool seq_check(Goon_Ctx *ctx, Goon_Value *seq) {
+    for (size_t i = 0; i < seq->data.seq.len; i++) {
+        if (!scratch_begin(ctx)) return false;
+        Goon_Value *item = seq_get(ctx, seq, i, false);
+        bool ok = item && !ctx->error.message && !ctx->memory_exceeded;
+        scratch_end(ctx);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static Goon_Value *seq_get(Goon_Ctx *ctx, Goon_Value *seq, size_t index, bool keep) {
+    if (seq->data.seq.fn && keep && !shared_lock(ctx) && !seq_fill(ctx, seq)) return NULL;
+    if (seq->data.seq.parts) {
+        Goon_List_Part *parts = seq->data.seq.parts;
+        size_t lo = 0;
+        size_t hi = seq->data.seq.part_count - 1;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (parts[mid].end <= index) lo = mid + 1;
+            else hi = mid;
+        }
+        size_t base = lo > 0 ? parts[lo - 1].end : 0;
+        return list_read(ctx, parts[lo].list, parts[lo].start + index - base, keep);
+    }
+    if (!seq->data.seq.source) return goon_int(ctx, seq_int(seq, index));
+
+    Goon_Value *item = list_get(ctx, seq->data.seq.source, index);
+    if (!item) return NULL;
+    Goon_Value *args[1] = { item };
+    return force(call_value(ctx, seq->data.seq.fn, args, 1));
+}
+
+static bool list_extend(Goon_Ctx *ctx, Goon_Value *list, Goon_Value *items) {
+    Goon_Type type = value_type(items);
+    size_t len = list->data.list.len;
+    if (type == GOON_LIST) {
+        size_t count = items->data.list.len;
+        if (count == 0) return true;
+        if (!list_reserve(ctx, list, len + count)) return false;
+        list_note(list, len, items->data.list.kind);
+        memcpy(list->data.list.items + len, items->data.list.items, count * sizeof(Goon_Value *));
+        list->data.list.len = len + count;
+    } else if (type == GOON_SEQ && items->data.seq.parts) {
+        if (!list_reserve(ctx, list, len + items->data.seq.len)) return false;
+        list_note(list, len, LIST_UNKNOWN);
+        size_t begin = 0;
+        for (size_t i = 0; i < items->data.seq.part_count; i++) {
+            Goon_List_Part *part = &items->data.seq.parts[i];
+            size_t count = part->end - begin;
+            if (value_type(part->list) == GOON_LIST) {
+                memcpy(list->data.list.items + list->data.list.len,
+                       part->list->data.list.items + part->start,
+                       count * sizeof(Goon_Value *));
+                list->data.list.len += count;
+            } else {
+                for (size_t j = 0; j < count; j++) {
+                    Goon_Value *item = seq_get(ctx, part->list, part->start + j, false);
+                    if (!item) return false;
+                    list->data.list.items[list->data.list.len++] = item;
+                }
+            }
+            begin = part->end;
+        }
+    } else if (type == GOON_SEQ) {
+        if (!list_reserve(ctx, list, len + items->data.seq.len)) return false;
+        for (size_t i = 0; i < items->data.seq.len; i++) {
+            Goon_Value *item = seq_get(ctx, items, i, false);
+            if (!item) return false;
+            goon_list_push(ctx, list, item);
+            if (ctx->memory_exceeded) return false;
+        }
+    }
+    return true;
+}
+
+static Goon_Value *force_slot(Goon_Value **slot) {
+    Goon_Value *val = *slot;
+    if (value_type(val) != GOON_THUNK) return val;
+    val = force(val);
+    if (val) *slot = val;
+    return val;
+}
+
+static Goon_Value *list_read(Goon_Ctx *ctx, Goon_Value *list, size_t index, bool keep) {
+    Goon_Type type = value_type(list);
+    if (type == GOON_SEQ) {
+        return index < list->data.seq.len ? seq_get(ctx, list, index, keep) : NULL;
+    }
+    if (type != GOON_LIST) return NULL;
+    if (index >= list->data.list.len) return NULL;
+    return force_slot(&list->data.list.items[index]);
+}
+
+Goon_Value *goon_list_get(Goon_Value *list, size_t index) {
+    if (value_type(list) != GOON_SEQ) return list_get(NULL, list, index);
+    Goon_Ctx *ctx = list->data.seq.ctx;
+    pthread_mutex_t *lock = shared_lock(ctx);
+    if (lock) pthread_mutex_lock(lock);
+    Goon_Value *item = list_read(ctx, list, index, true);
+    if (lock) pthread_mutex_unlock(lock);
+    return item;
+}
+
+static void *list_pack(Goon_Value *list, uint8_t kind, size_t *len) {
+    *len = 0;
+    size_t count = goon_list_len(list);
+    if (count == 0) return NULL;
+    bool flat = value_type(list) == GOON_LIST;
+    Goon_Ctx *ctx = flat ? list->data.list.ctx : list->data.seq.ctx;
+    pthread_mutex_t *lock = shared_lock(ctx);
+    if (flat) {
+        if (list->data.list.packed && list->data.list.kind == kind) {
+            *len = count;
+            return list->data.list.packed;
+        }
+        if (!lock && list_kind(list) == LIST_MIXED) return NULL;
+    }
+
+    size_t size = kind == LIST_INTS ? sizeof(int64_t) : sizeof(Goon_Str);
+    void *packed = NULL;
+    if (lock) pthread_mutex_lock(lock);
+    bool paused = scratch_pause(ctx, list);
+    for (size_t i = 0; i < count; i++) {
+        Goon_Value *item = list_get(ctx, list, i);
+        if (elem_kind(item) != kind) {
+            packed = NULL;
+            break;
+        }
+        if (!packed) {
+            packed = ctx_alloc(ctx, count * size);
+            if (!packed) break;
+        }
+        if (kind == LIST_INTS) ((int64_t *)packed)[i] = int_value(item);
+        else ((Goon_Str *)packed)[i] = goon_to_str(item);
+    }
+    scratch_resume(ctx, paused);
+    if (lock) pthread_mutex_unlock(lock);
+
+    if (!packed) return NULL;
+    if (flat && !lock) {
+        list->data.list.kind = kind;
+        list->data.list.packed = packed;
+    }
+    *len = count;
+    return packed;
+}
+
+const int64_t *goon_list_ints(Goon_Value *list, size_t *len) {
+    return list_pack(list, LIST_INTS, len);
+}
+
+const Goon_Str *goon_list_strs(Goon_Value *list, size_t *len) {
+    return list_pack(list, LIST_STRINGS, len);
+}
+
+static Goon_Value *list_flatten(Goon_Ctx *ctx, Goon_Value *seq) {
+    Goon_Value *list = list_sized(ctx, seq->data.seq.len);
+    if (!list || !list_extend(ctx, list, seq)) return NULL;
+    return list;
+}
+
+static Goon_Value *list_view(Goon_Ctx *ctx, Goon_List_Part *parts, size_t count, size_t len) {
+    Goon_Value *val = alloc_value(ctx, GOON_SEQ);
+    if (!val) return NULL;
+    val->data.seq.source = NULL;
+    val->data.seq.fn = NULL;
+    val->data.seq.start = 0;
+    val->data.seq.step = 0;
+    val->data.seq.len = len;
+    val->data.seq.ctx = home_ctx(ctx);
+    val->data.seq.parts = parts;
+    val->data.seq.part_count = count;
+    return val;
+}
+
+static Goon_Value *list_join(Goon_Ctx *ctx, Goon_Value **lists, size_t count) {
+    size_t total = 0;
+    size_t part_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        Goon_Value *list = lists[i];
+        if (!goon_is_list(list)) continue;
+        size_t len = goon_list_len(list);
+        if (len == 0) continue;
+        total += len;
+        part_count += seq_is_view(list) ? list->data.seq.part_count : 1;
+    }
+
+    if (total < LIST_VIEW_MIN || part_count > LIST_MAX_PARTS) {
+        Goon_Value *result = list_sized(ctx, total);
+        if (!result) return NULL;
+        for (size_t i = 0; i < count; i++) {
+            if (goon_is_list(lists[i]) && !list_extend(ctx, result, lists[i])) return NULL;
+        }
+        return result;
+    }
+
+    Goon_List_Part *parts = ctx_alloc(ctx, part_count * sizeof(Goon_List_Part));
+    if (!parts) return NULL;
+    size_t n = 0;
+    size_t end = 0;
+    for (size_t i = 0; i < count; i++) {
+        Goon_Value *list = lists[i];
+        if (!goon_is_list(list)) continue;
+        size_t len = goon_list_len(list);
+        if (len == 0) continue;
+        if (seq_is_view(list)) {
+            for (size_t j = 0; j < list->data.seq.part_count; j++) {
+                parts[n] = list->data.seq.parts[j];
+                parts[n++].end += end;
+            }
+        } else {
+            parts[n].list = list;
+            parts[n].start = 0;
+            parts[n++].end = end + len;
+        }
+        end += len;
+    }
+    return list_view(ctx, parts, n, total);
+}
+
+static Goon_Value *list_slice(Goon_Ctx *ctx, Goon_Value *list, size_t start, size_t end) {
+    if (value_type(list) == GOON_SEQ && list->data.seq.fn && !seq_fill(ctx, list)) return NULL;
+    size_t len = end - start;
+    if (len < LIST_VIEW_MIN) {
+        Goon_Value *result = list_sized(ctx, len);
+        if (!result) return NULL;
+        for (size_t i = start; i < end; i++) {
+            Goon_Value *item = list_get(ctx, list, i);
+            if (!item) return NULL;
+            result->data.list.items[result->data.list.len++] = item;
+        }
+        return result;
+    }
+
+    Goon_List_Part whole = { list, 0, goon_list_len(list) };
+    Goon_List_Part *src = &whole;
+    size_t src_count = 1;
+    if (seq_is_view(list)) {
+        src = list->data.seq.parts;
+        src_count = list->data.seq.part_count;
+    }
+
+    Goon_List_Part *parts = ctx_alloc(ctx, src_count * sizeof(Goon_List_Part));
+    if (!parts) return NULL;
+    size_t n = 0;
+    size_t begin = 0;
+    for (size_t i = 0; i < src_count; i++) {
+        size_t lo = start > begin ? start : begin;
+        size_t hi = end < src[i].end ? end : src[i].end;
+        if (lo < hi) {
+            parts[n].list = src[i].list;
+            parts[n].start = src[i].start + (lo - begin);
+            parts[n++].end = hi - start;
+        }
+        begin = src[i].end;
+    }
+    return list_view(ctx, parts, n, len);
+}
+
+#define RECORD_INLINE 8
+#define RECORD_MAX_DEPTH 4
+#define SHAPE_MAX_SHARED 64
+#define SLOT_NONE UINT32_MAX
+
+typedef struct {
+    const Goon_Symbol **keys;
+    uint32_t *index;
+    uint32_t len;
+    uint32_t cap;
+} Shape_Table;
+
+struct Goon_Shape {
+    Shape_Table *table;
+    Goon_Shape *children;
+    Goon_Shape *sibling;
+    const Goon_Symbol *key;
+    uint32_t count;
+    bool unique;
+};
+
+static void table_index_put(Shape_Table *table, uint32_t slot) {
+    uint32_t mask = table->cap * 2 - 1;
+    uint32_t i = table->keys[slot]->hash & mask;
+    while (table->index[i]) i = (i + 1) & mask;
+    table->index[i] = slot + 1;
+}
+
+static bool table_push(Goon_Ctx *ctx, Shape_Table *table, const Goon_Symbol *key) {
+    if (table->len == table->cap) {
+        uint32_t cap = table->cap ? table->cap * 2 : 4;
+        const Goon_Symbol **keys = ctx_alloc(ctx, cap * sizeof(*keys));
+        if (!keys) return false;
+        if (table->len > 0) memcpy(keys, table->keys, table->len * sizeof(*keys));
+
+        uint32_t *index = NULL;
+        if (cap > RECORD_INLINE) {
+            index = ctx_alloc(ctx, cap * 2 * sizeof(uint32_t));
+            if (!index) return false;
+            memset(index, 0, cap * 2 * sizeof(uint32_t));
+        }
+        table->keys = keys;
+        table->index = index;
+        table->cap = cap;
+        if (index) {
+            for (uint32_t i = 0; i < table->len; i++) table_index_put(table, i);
+        }
+    }
+    table->keys[table->len] = key;
+    if (table->index) table_index_put(table, table->len);
+    table->len++;
+    return true;
+}
+
+static Shape_Table *table_create(Goon_Ctx *ctx, const Shape_Table *from, uint32_t count) {
+    Shape_Table *table = ctx_alloc(ctx, sizeof(Shape_Table));
+    if (!table) return NULL;
+    memset(table, 0, sizeof(Shape_Table));
+    for (uint32_t i = 0; i < count; i++) {
+        if (!table_push(ctx, table, from->keys[i])) return NULL;
+    }
+    return table;
+}
+
+static Goon_Shape *shape_create(Goon_Ctx *ctx, Shape_Table *table, const Goon_Symbol *key, uint32_t count) {
+    Goon_Shape *shape = ctx_alloc(ctx, sizeof(Goon_Shape));
+    if (!shape) return NULL;
+    shape->table = table;
+    shape->children = NULL;
+    shape->sibling = NULL;
+    shape->key = key;
+    shape->count = count;
+    shape->unique = false;
+    ctx->stats.shapes++;
+    return shape;
+}
+
+static Goon_Shape *shape_root(Goon_Ctx *ctx) {
+    Shape_Table *table = table_create(ctx, NULL, 0);
+    return table ? shape_create(ctx, table, NULL, 0) : NULL;
+}
+
+static uint32_t shape_find(const Goon_Shape *shape, const Goon_Symbol *sym) {
+    const Shape_Table *table = shape->table;
+    if (!table->index) {
+        for (uint32_t i = 0; i < shape->count; i++) {
+            if (table->keys[i] == sym) return i;
+        }
+        return SLOT_NONE;
+    }
+    uint32_t mask = table->cap * 2 - 1;
+    for (uint32_t i = sym->hash & mask; table->index[i]; i = (i + 1) & mask) {
+        uint32_t slot = table->index[i] - 1;
+        if (table->keys[slot] == sym) return slot < shape->count ? slot : SLOT_NONE;
+    }
+    return SLOT_NONE;
+}
+
+static uint32_t shape_find_name(const Goon_Shape *shape, const char *key, size_t len, uint32_t hash) {
+    const Shape_Table *table = shape->table;
+    if (!table->index) {
+        for (uint32_t i = 0; i < shape->count; i++) {
+            const Goon_Symbol *sym = table->keys[i];
+            if (sym->hash == hash && sym->len == len && memcmp(sym->name, key, len) == 0) return i;
+        }
+        return SLOT_NONE;
+    }
+    uint32_t mask = table->cap * 2 - 1;
+    for (uint32_t i = hash & mask; table->index[i]; i = (i + 1) & mask) {
+        uint32_t slot = table->index[i] - 1;
+        const Goon_Symbol *sym = table->keys[slot];
+        if (sym->hash == hash && sym->len == len && memcmp(sym->name, key, len) == 0) {
+            return slot < shape->count ? slot : SLOT_NONE;
+        }
+    }
+    return SLOT_NONE;
+}
+
+static Goon_Shape *shape_grow(Goon_Ctx *ctx, Goon_Shape *shape, const Goon_Symbol *key) {
+    if (shape->unique) {
+        if (!table_push(ctx, shape->table, key)) return NULL;
+        shape->count++;
+        return shape;
+    }
+    for (Goon_Shape *child = shape->children; child; child = child->sibling) {
+        if (child->key == key) return child;
+    }
+
+    bool unique = shape->count >= SHAPE_MAX_SHARED;
+    Shape_Table *table = shape->table;
+    if (unique || shape->count != table->len) {
+        table = table_create(ctx, table, shape->count);
+        if (!table) return NULL;
+    }
+    if (!table_push(ctx, table, key)) return NULL;
+
+    Goon_Shape *next = shape_create(ctx, table, key, shape->count + 1);
+    if (!next) return NULL;
+    if (unique) {
+        next->unique = true;
+    } else {
+        next->sibling = shape->children;
+        shape->children = next;
+    }
+    return next;
+}
+
+static Goon_Shape *shape_add(Goon_Ctx *ctx, Goon_Shape *shape, const Goon_Symbol *key) {
+    bool paused = scratch_pause(ctx, NULL);
+    Goon_Shape *next = shape_grow(ctx, shape, key);
+    scratch_resume(ctx, paused);
+    return next;
+}
+
+static Goon_Value **record_find_own(Goon_Value *record, const Goon_Symbol *sym) {
+    uint32_t slot = shape_find(record->data.record.shape, sym);
+    return slot == SLOT_NONE ? NULL : &record->data.record.values[slot];
+}
+
+static Goon_Value **record_find(Goon_Value *record, const Goon_Symbol *sym) {
+    for (; record; record = record->data.record.parent) {
+        Goon_Value **slot = record_find_own(record, sym);
+        if (slot) return slot;
+    }
+    return NULL;
+}
+
+static Goon_Value **record_iter_slot(Goon_Record_Iter *it, const Goon_Symbol **key) {
+    Goon_Value *top = it->record;
+    while (it->level) {
+        Goon_Value *level = it->level;
+        Goon_Shape *shape = level->data.record.shape;
+        Goon_Value *parent = level->data.record.parent;
+        while (it->slot < shape->count) {
+            uint32_t slot = it->slot++;
+            const Goon_Symbol *sym = shape->table->keys[slot];
+            if (parent && record_find(parent, sym)) continue;
+            it->pos++;
+            *key = sym;
+            return level == top ? &level->data.record.values[slot] : record_find(top, sym);
+        }
+        if (level == top) break;
+        Goon_Value *child = top;
+        while (child->data.record.parent != level) child = child->data.record.parent;
+        it->level = child;
+        it->slot = 0;
+    }
+    it->level = NULL;
+    return NULL;
+}
+
+static bool record_reserve(Goon_Ctx *ctx, Goon_Value *record, uint32_t need) {
+    uint32_t cap = record->data.record.cap;
+    if (need <= cap) return true;
+    if (cap == 0) cap = 4;
+    while (cap < need) cap *= 2;
+
+    uint32_t count = record->data.record.shape->count;
+    Goon_Value **values = ctx_alloc(ctx, cap * sizeof(Goon_Value *));
+    if (!values) return false;
+    if (count > 0) memcpy(values, record->data.record.values, count * sizeof(Goon_Value *));
+    record->data.record.values = values;
+    record->data.record.cap = cap;
+    return true;
+}
+
+void goon_record_set_sym(Goon_Ctx *ctx, Goon_Value *record, const Goon_Symbol *sym, Goon_Value *value) {
+    if (value_type(record) != GOON_RECORD || record->frozen || !sym) return;
+
+    Goon_Value **slot = record_find_own(record, sym);
+    if (slot) {
+        *slot = value;
+        return;
+    }
+
+    uint32_t count = record->data.record.shape->count;
+    if (!record_reserve(ctx, record, count + 1)) return;
+    Goon_Shape *next = shape_add(ctx, record->data.record.shape, sym);
+    if (!next) return;
+
+    Goon_Value *parent = record->data.record.parent;
+    if (!parent || !record_find(parent, sym)) record->data.record.size++;
+    record->data.record.values[count] = value;
+    record->data.record.shape = next;
+    ctx->stats.fields++;
+}
+
+static void record_set_cached(Goon_Ctx *ctx, Goon_Value *record, const Goon_Symbol *sym, Goon_Value *value, Goon_Field_Cache *cache) {
+    Goon_Shape *shape = record->data.record.shape;
+    if (shape == cache->shape && !record->data.record.parent) {
+        if (cache->next == shape) {
+            record->data.record.values[cache->slot] = value;
+            return;
+        }
+        if (!record_reserve(ctx, record, cache->slot + 1)) return;
+        record->data.record.values[cache->slot] = value;
+        record->data.record.shape = cache->next;
+        record->data.record.size++;
+        ctx->stats.fields++;
+        return;
+    }
+
+    goon_record_set_sym(ctx, record, sym, value);
+    Goon_Shape *next = record->data.record.shape;
+    if (ctx->parent || record->data.record.parent || shape->unique || next->unique) return;
+    cache->shape = shape;
+    cache->next = next;
+    cache->slot = shape_find(next, sym);
+}
+
+void goon_record_set(Goon_Ctx *ctx, Goon_Value *record, const char *key, Goon_Value *value) {
+    goon_record_set_sym(ctx, record, goon_intern(ctx, key), value);
+}
+
+Goon_Value *goon_record_get_sym(Goon_Value *record, const Goon_Symbol *sym) {
+    if (value_type(record) != GOON_RECORD || !sym) return NULL;
+    Goon_Value **slot = record_find(record, sym);
+    return slot ? force_slot(slot) : NULL;
+}
+
+static Goon_Value **record_slot_cached(Goon_Value *record, const Goon_Symbol *sym, Goon_Field_Cache *cache, bool update) {
+    if (value_type(record) != GOON_RECORD || !sym) return NULL;
+    Goon_Shape *shape = record->data.record.shape;
+    if (shape == cache->shape) return &record->data.record.values[cache->slot];
+
+    uint32_t slot = shape_find(shape, sym);
+    if (slot == SLOT_NONE) return record_find(record->data.record.parent, sym);
+    if (update) {
+        cache->shape = shape;
+        cache->next = shape;
+        cache->slot = slot;
+    }
+    return &record->data.record.values[slot];
+}
+
+static Goon_Value *record_get_cached(Goon_Value *record, const Goon_Symbol *sym, Goon_Field_Cache *cache, bool update) {
+    Goon_Value **slot = record_slot_cached(record, sym, cache, update);
+    return slot ? force_slot(slot) : NULL;
+}
+
+Goon_Value *goon_record_get_cached(Goon_Value *record, const Goon_Symbol *sym, Goon_Field_Cache *cache) {
+    return record_get_cached(record, sym, cache, true);
+}
+
+Goon_Value *goon_record_get(Goon_Value *record, const char *key) {
+    if (value_type(record) != GOON_RECORD) return NULL;
+    size_t len = strlen(key);
+    uint32_t hash = hash_bytes(key, len);
+    for (; record; record = record->data.record.parent) {
+        uint32_t slot = shape_find_name(record->data.record.shape, key, len, hash);
+        if (slot != SLOT_NONE) return force_slot(&record->data.record.values[slot]);
+    }
+    return NULL;
+}
+
+static void record_spread(Goon_Ctx *ctx, Goon_Value *record, Goon_Value *from) {
+    if (from->frozen && record->data.record.size == 0 && !record->data.record.parent &&
+        from->data.record.depth < RECORD_MAX_DEPTH) {
+        record->data.record.parent = from;
+        record->data.record.size = from->data.record.size;
+        record->data.record.depth = from->data.record.depth + 1;
+        return;
+    }
+
+    size_t size = from->data.record.size;
+    uint32_t count = record->data.record.shape->count;
+    if (!record->data.record.parent && !record_reserve(ctx, record, count + (uint32_t)size)) return;
+    Goon_Record_Iter it = goon_record_iter(from);
+    const Goon_Symbol *key;
+    Goon_Value **slot;
+    while ((slot = record_iter_slot(&it, &key))) {
+        goon_record_set_sym(ctx, record, key, *slot);
+    }
+}
+
+static Goon_Value *record_copy(Goon_Ctx *ctx, Goon_Value *record) {
+    Goon_Value *copy = goon_record(ctx);
+    if (copy) record_spread(ctx, copy, record);
+    return copy;
+}
+
+static void record_flatten(Goon_Ctx *ctx, Goon_Value *record) {
+    uint32_t size = record->data.record.size;
+    Goon_Value **values = ctx_alloc(ctx, size * sizeof(Goon_Value *));
+    if (!values) return;
+    Goon_Shape *shape = ctx->empty_shape;
+    Goon_Record_Iter it = goon_record_iter(record);
+    for (uint32_t i = 0; i < size; i++) {
+        const Goon_Symbol *key;
+        values[i] = *record_iter_slot(&it, &key);
+        shape = shape_add(ctx, shape, key);
+        if (!shape) return;
+    }
+    record->data.record.shape = shape;
+    record->data.record.values = values;
+    record->data.record.cap = size;
+    record->data.record.parent = NULL;
+    record->data.record.depth = 0;
+}
+
+static void record_seal(Goon_Ctx *ctx, Goon_Value *record) {
+    record->frozen = true;
+    uint32_t count = record->data.record.shape->count;
+    for (uint32_t i = 0; i < count; i++) {
+        Goon_Value *val = record->data.record.values[i];
+        if (value_type(val) == GOON_RECORD && !val->frozen) record_seal(ctx, val);
+    }
+    Goon_Value *parent = record->data.record.parent;
+    if (parent && count > parent->data.record.size / 2 + RECORD_INLINE) {
+        record_flatten(ctx, record);
+    }
+}
+
+static void goon_record_set_path(Goon_Ctx *ctx, Goon_Value *record, const Goon_Symbol **path, size_t path_len, Goon_Value *value) {
     if (path_len == 0) return;
 
     if (path_len == 1) {
-        goon_record_set(ctx, record, path[0], value);
+        goon_record_set_sym(ctx, record, path[0], value);
         return;
     }
 
-    Goon_Value *existing = goon_record_get(record, path[0]);
+    Goon_Value *existing = goon_record_get_sym(record, path[0]);
     Goon_Value *intermediate;
 
-    if (existing && existing->type == GOON_RECORD) {
+    if (value_type(existing) == GOON_RECORD && !existing->frozen) {
         intermediate = existing;
+    } else if (value_type(existing) == GOON_RECORD) {
+        intermediate = record_copy(ctx, existing);
+        goon_record_set_sym(ctx, record, path[0], intermediate);
     } else {
         intermediate = goon_record(ctx);
-        goon_record_set(ctx, record, path[0], intermediate);
+        goon_record_set_sym(ctx, record, path[0], intermediate);
+    }
+
+    goon_record_set_path(ctx, intermediate, path + 1, path_len - 1, value);
+}
+
+size_t goon_record_len(Goon_Value *record) {
+    if (value_type(record) != GOON_RECORD) return 0;
+    return record->data.record.size;
+}
+
+Goon_Record_Iter goon_record_iter(Goon_Value *record) {
+    Goon_Record_Iter it;
+    memset(&it, 0, sizeof(it));
+    if (value_type(record) != GOON_RECORD) return it;
+    it.record = record;
+    it.level = record;
+    while (it.level->data.record.parent) it.level = it.level->data.record.parent;
+    return it;
+}
+
+Goon_Record_Field *goon_record_next(Goon_Record_Iter *it) {
+    const Goon_Symbol *key;
+    Goon_Value **slot = record_iter_slot(it, &key);
+    if (!slot) return NULL;
+    Goon_Value *val = force_slot(slot);
+    if (!val) return NULL;
+    it->field.key = key->name;
+    it->field.sym = key;
+    it->field.value = val;
+    return &it->field;
+}
+
+static void bind(Goon_Ctx *ctx, Goon_Binding **env, const Goon_Symbol *name, Goon_Value *value) {
+    Goon_Binding *b = *env;
+    while (b) {
+        if (b->name == name) {
+            b->value = value;
+            return;
+        }
+        b = b->next;
+    }
+    b = ctx_alloc(ctx, sizeof(Goon_Binding));
+    if (!b) return;
+    ctx->stats.bindings++;
+    b->name = name;
+    b->value = value;
+    b->next = *env;
+    *env = b;
+}
+
+typedef enum {
+    NODE_INT,
+    NODE_STRING,
+    NODE_INTERP,
+    NODE_TRUE,
+    NODE_FALSE,
+    NODE_VAR,
+    NODE_FIELD,
+    NODE_CALL,
+    NODE_RECORD,
+    NODE_LIST,
+    NODE_RANGE,
+    NODE_SPREAD,
+    NODE_LAMBDA,
+    NODE_IF,
+    NODE_LET,
+    NODE_IMPORT,
+} Node_Type;
+
+typedef struct {
+    const Goon_Symbol **path;
+    size_t path_len;
+    Node *value;
+} Record_Item;
+
+typedef struct {
+    const char *text;
+    size_t len;
+    Node *expr;
+} Interp_Part;
+
+typedef enum {
+    FOLD_UNKNOWN,
+    FOLD_CONST,
+    FOLD_DYNAMIC,
+} Fold_State;
+
+struct Goon_Node {
+    Node_Type type;
+    uint32_t pos;
+    Fold_State fold;
+    Goon_Value *folded;
+    union {
+        int64_t integer;
+        struct {
+            const char *ptr;
+            size_t len;
+            bool terminated;
+        } string;
+        struct {
+            Interp_Part *parts;
+            size_t count;
+        } interp;
+        const Goon_Symbol *var;
+        struct {
+            Node *object;
+            const Goon_Symbol *name;
+        } field;
+        struct {
+            const Goon_Symbol *name;
+            Node **args;
+            size_t argc;
+        } call;
+        struct {
+            Record_Item *items;
+            size_t count;
+        } record;
+        struct {
+            Node **items;
+            size_t count;
+        } list;
+        struct {
+            int64_t start;
+            int64_t end;
+        } range;
+        Node *spread;
+        struct {
+            const Goon_Symbol **params;
+            size_t param_count;
+            Node *body;
+        } lambda;
+        struct {
+            Node *cond;
+            Node *then_branch;
+            Node *else_branch;
+        } cond;
+        struct {
+            const Goon_Symbol *name;
+            Node *value;
+        } let;
+        const char *import_path;
+    } data;
+};
+
+typedef struct {
+    Goon_Ctx *ctx;
+    Goon_Source *src;
+    const Token *tok;
+} Parser;
+
+static void set_error(Goon_Ctx *ctx, Goon_Source *src, size_t pos, const char *msg);
+
+static void parser_init(Parser *p, Goon_Ctx *ctx, Goon_Source *src) {
+    p->ctx = ctx;
+    p->src = src;
+    p->tok = src->tokens;
+}
+
+static void parser_advance(Parser *p) {
+    if (p->tok->type != TOK_EOF) p->tok++;
+}
+
+static void parser_error(Parser *p, const char *msg) {
+    set_error(p->ctx, p->src, p->tok->start, msg);
+}
+
+static void *parser_alloc(Parser *p, size_t size) {
+    void *mem = arena_alloc(&p->src->arena, size);
+    if (!mem) parser_error(p, "out of memory");
+    return mem;
+}
+
+static Node *new_node(Parser *p, Node_Type type, const Token *at) {
+    Node *n = parser_alloc(p, sizeof(Node));
+    if (!n) return NULL;
+    n->type = type;
+    n->pos = at->start;
+    n->fold = FOLD_UNKNOWN;
+    n->folded = NULL;
+    return n;
+}
+
+static void *vec_push(Parser *p, void **items, size_t *len, size_t *cap, size_t elem_size) {
+    if (*len >= *cap) {
+        size_t new_cap = *cap == 0 ? 8 : *cap * 2;
+        void *new_items = realloc(*items, new_cap * elem_size);
+        if (!new_items) {
+            parser_error(p, "out of memory");
+            return NULL;
+        }
+        *items = new_items;
+        *cap = new_cap;
+    }
+    return (char *)*items + (*len)++ * elem_size;
+}
+
+static void *vec_finish(Parser *p, void *items, size_t len, size_t elem_size) {
+    void *out = NULL;
+    if (len > 0) {
+        out = parser_alloc(p, len * elem_size);
+        if (out) memcpy(out, items, len * elem_size);
+    }
+    free(items);
+    return out;
+}
+
+static Node *parse_expr(Parser *p);
+
+static Node *parse_placeholder(Parser *p, const Token *tok, const char *text, size_t len) {
+    size_t seg = 0;
+    bool valid = len > 0;
+    for (size_t i = 0; valid && i <= len; i++) {
+        if (i == len || text[i] == '.') {
+            valid = i > seg && char_is(text[seg], CC_ALPHA);
+            seg = i + 1;
+        } else if (!char_is(text[i], CC_ALPHA | CC_DIGIT)) {
+            valid = false;
+        }
+    }
+
+    Node *n = new_node(p, NODE_VAR, tok);
+    if (!n) return NULL;
+    if (!valid) {
+        n->data.var = symtab_intern(p->ctx->symbols, text, len);
+        return n;
+    }
+
+    size_t end = 0;
+    while (end < len && text[end] != '.') end++;
+    n->data.var = symtab_intern(p->ctx->symbols, text, end);
+    while (end < len) {
+        size_t start = end + 1;
+        end = start;
+        while (end < len && text[end] != '.') end++;
+        Node *field = new_node(p, NODE_FIELD, tok);
+        if (!field) return NULL;
+        field->data.field.object = n;
+        field->data.field.name = symtab_intern(p->ctx->symbols, text + start, end - start);
+        n = field;
+    }
+    return n;
+}
+
+static Node *parse_string(Parser *p) {
+    const Token *tok = p->tok;
+    const char *str = p->src->text + tok->start + 1;
+    size_t len = tok->len - 2;
+    parser_advance(p);
+
+    bool plain = memchr(str, '\\', len) == NULL;
+    for (const char *d = str; plain && (d = memchr(d, '$', str + len - d)) != NULL; d++) {
+        if (d + 1 < str + len && d[1] == '{') plain = false;
+    }
+    if (plain) {
+        Node *n = new_node(p, NODE_STRING, tok);
+        if (!n) return NULL;
+        n->data.string.ptr = str;
+        n->data.string.len = len;
+        n->data.string.terminated = false;
+        return n;
+    }
+
+    char *buf = parser_alloc(p, len + 1);
+    if (!buf) return NULL;
+    size_t buf_len = 0;
+    size_t seg_start = 0;
+
+    Interp_Part *parts = NULL;
+    size_t part_count = 0;
+    size_t part_cap = 0;
+
+    size_t i = 0;
+    while (i < len) {
+        char ch = str[i];
+        if (ch == '\\' && i + 1 < len) {
+            ch = str[i + 1];
+            switch (ch) {
+                case 'n': ch = '\n'; break;
+                case 't': ch = '\t'; break;
+                case 'r': ch = '\r'; break;
+                default: break;
+            }
+            buf[buf_len++] = ch;
+            i += 2;
+        } else if (ch == '$' && i + 1 < len && str[i + 1] == '{') {
+            i += 2;
+            size_t var_start = i;
+            while (i < len && str[i] != '}') {
+                i++;
+            }
+            if (i < len) {
+                Interp_Part *part = vec_push(p, (void **)&parts, &part_count, &part_cap, sizeof(Interp_Part));
+                if (!part) {
+                    free(parts);
+                    return NULL;
+                }
+                part->text = buf + seg_start;
+                part->len = buf_len - seg_start;
+                part->expr = parse_placeholder(p, tok, str + var_start, i - var_start);
+                if (!part->expr) {
+                    free(parts);
+                    return NULL;
+                }
+                seg_start = buf_len;
+                i++;
+            }
+        } else {
+            buf[buf_len++] = ch;
+            i++;
+        }
+    }
+    buf[buf_len] = '\0';
+
+    if (part_count == 0) {
+        free(parts);
+        Node *n = new_node(p, NODE_STRING, tok);
+        if (!n) return NULL;
+        n->data.string.ptr = buf;
+        n->data.string.len = buf_len;
+        n->data.string.terminated = true;
+        return n;
+    }
+
+    Interp_Part *tail = vec_push(p, (void **)&parts, &part_count, &part_cap, sizeof(Interp_Part));
+    if (!tail) {
+        free(parts);
+        return NULL;
+    }
+    tail->text = buf + seg_start;
+    tail->len = buf_len - seg_start;
+    tail->expr = NULL;
+
+    Node *n = new_node(p, NODE_INTERP, tok);
+    if (!n) {
+        free(parts);
+        return NULL;
+    }
+    n->data.interp.count = part_count;
+    n->data.interp.parts = vec_finish(p, parts, part_count, sizeof(Interp_Part));
+    return n->data.interp.parts ? n : NULL;
+}
+
+static Node *parse_record(Parser *p) {
+    Node *n = new_node(p, NODE_RECORD, p->tok);
+    if (!n) return NULL;
+    parser_advance(p);
+
+    Record_Item *items = NULL;
+    size_t count = 0;
+    size_t cap = 0;
+
+    while (p->tok->type != TOK_RBRACE && p->tok->type != TOK_EOF) {
+        Record_Item *item = vec_push(p, (void **)&items, &count, &cap, sizeof(Record_Item));
+        if (!item) goto fail;
+
+        if (p->tok->type == TOK_SPREAD) {
+            parser_advance(p);
+            item->path = NULL;
+            item->path_len = 0;
+            item->value = parse_expr(p);
+            if (!item->value) goto fail;
+            if (p->tok->type == TOK_COMMA) {
+                parser_advance(p);
+            } else if (p->tok->type == TOK_SEMICOLON) {
+                parser_advance(p);
+            }
+            continue;
+        }
+
+        if (p->tok->type != TOK_IDENT) {
+            parser_error(p, "expected field name");
+            goto fail;
+        }
+
+        const Goon_Symbol *path[32];
+        size_t path_len = 0;
+
+        path[path_len++] = p->tok->data.sym;
+        parser_advance(p);
+
+        while (p->tok->type == TOK_DOT && path_len < 32) {
+            parser_advance(p);
+            if (p->tok->type != TOK_IDENT) {
+                parser_error(p, "expected field name after .");
+                goto fail;
+            }
+            path[path_len++] = p->tok->data.sym;
+            parser_advance(p);
+        }
+
+        if (p->tok->type == TOK_COLON) {
+            parser_advance(p);
+            parser_advance(p);
+        }
+
+        if (p->tok->type != TOK_EQUALS) {
+            parser_error(p, "expected = after field name");
+            goto fail;
+        }
+
+        parser_advance(p);
+
+        item->path = parser_alloc(p, path_len * sizeof(Goon_Symbol *));
+        if (!item->path) goto fail;
+        memcpy(item->path, path, path_len * sizeof(Goon_Symbol *));
+        item->path_len = path_len;
+        item->value = parse_expr(p);
+        if (!item->value) goto fail;
+
+        if (p->tok->type == TOK_SEMICOLON) {
+            parser_advance(p);
+        } else if (p->tok->type == TOK_COMMA) {
+            parser_advance(p);
+        }
+    }
+
+    if (p->tok->type != TOK_RBRACE) {
+        parser_error(p, "expected }");
+        goto fail;
+    }
+
+    parser_advance(p);
+    n->data.record.count = count;
+    n->data.record.items = vec_finish(p, items, count, sizeof(Record_Item));
+    return n;
+
+fail:
+    free(items);
+    return NULL;
+}
+
+static Node *parse_list(Parser *p) {
+    Node *n = new_node(p, NODE_LIST, p->tok);
+    if (!n) return NULL;
+    parser_advance(p);
+
+    Node **items = NULL;
+    size_t count = 0;
+    size_t cap = 0;
+
+    while (p->tok->type != TOK_RBRACKET && p->tok->type != TOK_EOF) {
+        Node **slot = vec_push(p, (void **)&items, &count, &cap, sizeof(Node *));
+        if (!slot) goto fail;
+
+        if (p->tok->type == TOK_SPREAD) {
+            *slot = new_node(p, NODE_SPREAD, p->tok);
+            if (!*slot) goto fail;
+            parser_advance(p);
+            (*slot)->data.spread = parse_expr(p);
+            if (!(*slot)->data.spread) goto fail;
+        } else if (p->tok->type == TOK_INT && p->tok[1].type == TOK_DOTDOT) {
+            *slot = new_node(p, NODE_RANGE, p->tok);
+            if (!*slot) goto fail;
+            (*slot)->data.range.start = p->tok->data.integer;
+            parser_advance(p);
+            parser_advance(p);
+            if (p->tok->type != TOK_INT) {
+                parser_error(p, "expected integer after ..");
+                goto fail;
+            }
+            (*slot)->data.range.end = p->tok->data.integer;
+            parser_advance(p);
+        } else {
+            *slot = parse_expr(p);
+            if (!*slot) goto fail;
+        }
+
+        if (p->tok->type == TOK_COMMA) {
+            parser_advance(p);
+        }
+    }
+
+    if (p->tok->type != TOK_RBRACKET) {
+        parser_error(p, "expected ]");
+        goto fail;
+    }
+
+    parser_advance(p);
+    n->data.list.count = count;
+    n->data.list.items = vec_finish(p, items, count, sizeof(Node *));
+    return n;
+
+fail:
+    free(items);
+    return NULL;
+}
+
+static Node *parse_import(Parser *p) {
+    Node *n = new_node(p, NODE_IMPORT, p->tok);
+    if (!n) return NULL;
+    parser_advance(p);
+
+    if (p->tok->type != TOK_LPAREN) {
+        parser_error(p, "expected ( after import");
+        return NULL;
+    }
+
+    parser_advance(p);
+
+    if (p->tok->type != TOK_STRING) {
+        parser_error(p, "expected string path in import");
+        return NULL;
+    }
+
+    char *path = token_string(p->src, p->tok);
+    if (!path) return NULL;
+    size_t path_len = strlen(path);
+    char *copy = parser_alloc(p, path_len + 1);
+    if (copy) memcpy(copy, path, path_len + 1);
+    free(path);
+    if (!copy) return NULL;
+    n->data.import_path = copy;
+    parser_advance(p);
+
+    if (p->tok->type != TOK_RPAREN) {
+        parser_error(p, "expected ) after import path");
+        return NULL;
+    }
+
+    parser_advance(p);
+    return n;
+}
+
+static Node *parse_call(Parser *p, const Token *name) {
+    Node *n = new_node(p, NODE_CALL, name);
+    if (!n) return NULL;
+    n->data.call.name = name->data.sym;
+    parser_advance(p);
+
+    Node *args[16];
+    size_t argc = 0;
+
+    while (p->tok->type != TOK_RPAREN && p->tok->type != TOK_EOF && argc < 16) {
+        args[argc] = parse_expr(p);
+        if (!args[argc]) return NULL;
+        argc++;
+        if (p->tok->type == TOK_COMMA) {
+            parser_advance(p);
+        }
+    }
+
+    if (p->tok->type != TOK_RPAREN) {
+        parser_error(p, "expected )");
+        return NULL;
+    }
+
+    parser_advance(p);
+
+    n->data.call.argc = argc;
+    n->data.call.args = NULL;
+    if (argc > 0) {
+        n->data.call.args = parser_alloc(p, argc * sizeof(Node *));
+        if (!n->data.call.args) return NULL;
+        memcpy(n->data.call.args, args, argc * sizeof(Node *));
+    }
+    return n;
+}
+
+static bool scan_lambda_params(const Token *t, const Token **body) {
+    t++;
+    if (t->type == TOK_RPAREN) {
+        t++;
+    } else {
+        for (;;) {
+            if (t->type != TOK_IDENT) return false;
+            t++;
+            if (t->type == TOK_COMMA) {
+                t++;
+            } else if (t->type == TOK_RPAREN) {
+                t++;
+                break;
+            } else {
+                return false;
+            }
+        }
+    }
+    if (t->type != TOK_ARROW) return false;
+    *body = t + 1;
+    return true;
+}
+
+static Node *parse_primary(Parser *p) {
+    const Token *tok = p->tok;
+
+    switch (tok->type) {
+        case TOK_INT: {
+            Node *n = new_node(p, NODE_INT, tok);
+            if (!n) return NULL;
+            n->data.integer = tok->data.integer;
+            parser_advance(p);
+            return n;
+        }
+
+        case TOK_STRING:
+            return parse_string(p);
+
+        case TOK_TRUE:
+        case TOK_FALSE: {
+            Node *n = new_node(p, tok->type == TOK_TRUE ? NODE_TRUE : NODE_FALSE, tok);
+            parser_advance(p);
+            return n;
+        }
+
+        case TOK_IDENT: {
+            parser_advance(p);
+
+            if (p->tok->type == TOK_LPAREN) {
+                return parse_call(p, tok);
+            }
+
+            Node *n = new_node(p, NODE_VAR, tok);
+            if (!n) return NULL;
+            n->data.var = tok->data.sym;
+
+            while (p->tok->type == TOK_DOT) {
+                parser_advance(p);
+                if (p->tok->type != TOK_IDENT) {
+                    parser_error(p, "expected field name after .");
+                    return NULL;
+                }
+                Node *field = new_node(p, NODE_FIELD, p->tok);
+                if (!field) return NULL;
+                field->data.field.object = n;
+                field->data.field.name = p->tok->data.sym;
+                n = field;
+                parser_advance(p);
+            }
+            return n;
+        }
+
+        case TOK_LBRACE:
+            return parse_record(p);
+
+        case TOK_LBRACKET:
+            return parse_list(p);
+
+        case TOK_IMPORT:
+            return parse_import(p);
+
+        case TOK_LPAREN: {
+            const Token *body;
+            if (!scan_lambda_params(tok, &body)) {
+                parser_advance(p);
+                Node *n = parse_expr(p);
+                if (!n) return NULL;
+                if (p->tok->type != TOK_RPAREN) {
+                    parser_error(p, "expected )");
+                    return NULL;
+                }
+                parser_advance(p);
+                return n;
+            }
+
+            Node *n = new_node(p, NODE_LAMBDA, tok);
+            if (!n) return NULL;
+
+            size_t param_count = 0;
+            for (const Token *t = tok + 1; t < body - 2; t++) {
+                if (t->type == TOK_IDENT) param_count++;
+            }
+            n->data.lambda.param_count = param_count;
+            n->data.lambda.params = NULL;
+            if (param_count > 0) {
+                n->data.lambda.params = parser_alloc(p, param_count * sizeof(Goon_Symbol *));
+                if (!n->data.lambda.params) return NULL;
+                size_t i = 0;
+                for (const Token *t = tok + 1; t < body - 2; t++) {
+                    if (t->type == TOK_IDENT) n->data.lambda.params[i++] = t->data.sym;
+                }
+            }
+
+            p->tok = body;
+            n->data.lambda.body = parse_expr(p);
+            return n->data.lambda.body ? n : NULL;
+        }
+
+        default:
+            parser_error(p, "expected expression");
+            return NULL;
+    }
+}
+
+static Node *parse_expr(Parser *p) {
+    if (p->tok->type == TOK_LET) {
+        Node *n = new_node(p, NODE_LET, p->tok);
+        if (!n) return NULL;
+        parser_advance(p);
+
+        if (p->tok->type != TOK_IDENT) {
+            parser_error(p, "expected identifier after let");
+            return NULL;
+        }
+
+        n->data.let.name = p->tok->data.sym;
+        parser_advance(p);
+
+        if (p->tok->type == TOK_COLON) {
+            parser_advance(p);
+            parser_advance(p);
+        }
+
+        if (p->tok->type != TOK_EQUALS) {
+            parser_error(p, "expected = in let binding");
+            return NULL;
+        }
+
+        parser_advance(p);
+
+        n->data.let.value = parse_expr(p);
+        if (!n->data.let.value) return NULL;
+
+        if (p->tok->type != TOK_SEMICOLON) {
+            parser_error(p, "expected ; after let binding");
+            return NULL;
+        }
+        parser_advance(p);
+
+        return n;
+    }
+
+    if (p->tok->type == TOK_IF) {
+        Node *n = new_node(p, NODE_IF, p->tok);
+        if (!n) return NULL;
+        parser_advance(p);
+
+        n->data.cond.cond = parse_expr(p);
+        if (!n->data.cond.cond) return NULL;
+
+        if (p->tok->type != TOK_THEN) {
+            parser_error(p, "expected 'then' after if condition");
+            return NULL;
+        }
+
+        parser_advance(p);
+
+        n->data.cond.then_branch = parse_expr(p);
+        if (!n->data.cond.then_branch) return NULL;
+
+        if (p->tok->type != TOK_ELSE) {
+            parser_error(p, "expected 'else' after then branch");
+            return NULL;
+        }
+
+        parser_advance(p);
+
+        n->data.cond.else_branch = parse_expr(p);
+        if (!n->data.cond.else_branch) return NULL;
+
+        return n;
+    }
+
+    Node *val = parse_primary(p);
+    if (!val) return NULL;
+
+    if (p->tok->type == TOK_QUESTION) {
+        Node *n = new_node(p, NODE_IF, p->tok);
+        if (!n) return NULL;
+        n->data.cond.cond = val;
+        parser_advance(p);
+
+        n->data.cond.then_branch = parse_expr(p);
+        if (!n->data.cond.then_branch) return NULL;
+
+        if (p->tok->type != TOK_COLON) {
+            parser_error(p, "expected : in ternary");
+            return NULL;
+        }
+
+        parser_advance(p);
+
+        n->data.cond.else_branch = parse_expr(p);
+        if (!n->data.cond.else_branch) return NULL;
+
+        return n;
+    }
+
+    return val;
+}
+
+static bool parse_program(Parser *p) {
+    Node **exprs = NULL;
+    size_t count = 0;
+    size_t cap = 0;
+
+    while (p->tok->type != TOK_EOF) {
+        Node **slot = vec_push(p, (void **)&exprs, &count, &cap, sizeof(Node *));
+        if (!slot || !(*slot = parse_expr(p))) {
+            free(exprs);
+            return false;
+        }
+    }
+
+    p->src->expr_count = count;
+    p->src->exprs = vec_finish(p, exprs, count, sizeof(Node *));
+    return true;
+}
+
+typedef enum {
+    OP_CONST,
+    OP_NIL,
+    OP_POP,
+    OP_LOAD_LOCAL,
+    OP_STORE_LOCAL,
+    OP_LOAD_CAPTURE,
+    OP_LOAD_GLOBAL,
+    OP_GET_FIELD,
+    OP_RECORD,
+    OP_SET_FIELD,
+    OP_SET_PATH,
+    OP_SPREAD_RECORD,
+    OP_SEAL,
+    OP_LIST,
+    OP_APPEND,
+    OP_JOIN_LIST,
+    OP_CONCAT,
+    OP_CLOSURE,
+    OP_THUNK,
+    OP_CALL,
+    OP_JUMP,
+    OP_JUMP_IF_FALSE,
+    OP_IMPORT,
+    OP_RETURN,
+    OP_COUNT,
+} Opcode;
+
+static const struct {
+    const char *name;
+    uint8_t operands;
+} op_info[OP_COUNT] = {
+    [OP_CONST] = { "CONST", 1 },
+    [OP_NIL] = { "NIL", 0 },
+    [OP_POP] = { "POP", 0 },
+    [OP_LOAD_LOCAL] = { "LOAD_LOCAL", 1 },
+    [OP_STORE_LOCAL] = { "STORE_LOCAL", 1 },
+    [OP_LOAD_CAPTURE] = { "LOAD_CAPTURE", 1 },
+    [OP_LOAD_GLOBAL] = { "LOAD_GLOBAL", 1 },
+    [OP_GET_FIELD] = { "GET_FIELD", 2 },
+    [OP_RECORD] = { "RECORD", 1 },
+    [OP_SET_FIELD] = { "SET_FIELD", 2 },
+    [OP_SET_PATH] = { "SET_PATH", 1 },
+    [OP_SPREAD_RECORD] = { "SPREAD_RECORD", 0 },
+    [OP_SEAL] = { "SEAL", 0 },
+    [OP_LIST] = { "LIST", 0 },
+    [OP_APPEND] = { "APPEND", 0 },
+    [OP_JOIN_LIST] = { "JOIN_LIST", 1 },
+    [OP_CONCAT] = { "CONCAT", 1 },
+    [OP_CLOSURE] = { "CLOSURE", 1 },
+    [OP_THUNK] = { "THUNK", 1 },
+    [OP_CALL] = { "CALL", 1 },
+    [OP_JUMP] = { "JUMP", 1 },
+    [OP_JUMP_IF_FALSE] = { "JUMP_IF_FALSE", 1 },
+    [OP_IMPORT] = { "IMPORT", 1 },
+    [OP_RETURN] = { "RETURN", 0 },
+};
+
+typedef struct {
+    const Goon_Symbol *name;
+    bool from_local;
+    uint32_t index;
+} Capture;
+
+struct Goon_Proto {
+    uint32_t *code;
+    uint32_t *pos;
+    size_t code_len;
+    size_t code_cap;
+    Goon_Value **consts;
+    size_t const_count;
+    size_t const_cap;
+    const Goon_Symbol **names;
+    size_t name_count;
+    size_t name_cap;
+    Goon_Field_Cache *caches;
+    size_t cache_count;
+    size_t cache_cap;
+    Proto **protos;
+    size_t proto_count;
+    size_t proto_cap;
+    const Goon_Symbol **locals;
+    size_t local_count;
+    size_t local_cap;
+    Capture *captures;
+    size_t capture_count;
+    size_t capture_cap;
+    size_t param_count;
+    size_t max_stack;
+    uint32_t def_pos;
+    Goon_Source *src;
+    Proto *next;
+};
+
+static Goon_Value *lookup_global(Goon_Ctx *ctx, const Goon_Symbol *name) {
+    for (Goon_Binding *b = ctx->globals; b; b = b->next) {
+        if (b->name == name) return b->value;
+    }
+    return NULL;
+}
+
+static Goon_Value *builtin_map(Goon_Ctx *ctx, Goon_Value **args, size_t argc);
+static Goon_Value *builtin_concat(Goon_Ctx *ctx, Goon_Value **args, size_t argc);
+static Goon_Value *builtin_zip(Goon_Ctx *ctx, Goon_Value **args, size_t argc);
+static Goon_Value *builtin_enumerate(Goon_Ctx *ctx, Goon_Value **args, size_t argc);
+
+typedef struct Compiler {
+    Goon_Ctx *ctx;
+    Goon_Source *src;
+    Proto *proto;
+    struct Compiler *parent;
+    Goon_Value **known;
+    size_t known_cap;
+    size_t branch_depth;
+    size_t depth;
+    bool failed;
+} Compiler;
+
+static bool vec_reserve(void **items, size_t *cap, size_t len, size_t elem_size) {
+    if (len < *cap) return true;
+    size_t new_cap = *cap == 0 ? 8 : *cap * 2;
+    while (new_cap <= len) new_cap *= 2;
+    void *new_items = realloc(*items, new_cap * elem_size);
+    if (!new_items) return false;
+    *items = new_items;
+    *cap = new_cap;
+    return true;
+}
+
+static Proto *proto_create(Compiler *c, uint32_t def_pos) {
+    Proto *proto = calloc(1, sizeof(Proto));
+    if (!proto) return NULL;
+    proto->def_pos = def_pos;
+    proto->src = c->src;
+    proto->next = c->src->protos;
+    c->src->protos = proto;
+    return proto;
+}
+
+static void proto_free(Proto *proto) {
+    free(proto->code);
+    free(proto->pos);
+    free(proto->consts);
+    free(proto->names);
+    free(proto->caches);
+    free(proto->protos);
+    free(proto->locals);
+    free(proto->captures);
+    free(proto);
+}
+
+static void compile_fail(Compiler *c, uint32_t pos, const char *msg) {
+    if (!c->failed) set_error(c->ctx, c->src, pos, msg);
+    c->failed = true;
+}
+
+static size_t emit(Compiler *c, uint32_t word, uint32_t pos) {
+    Proto *proto = c->proto;
+    size_t cap = proto->code_cap;
+    if (!vec_reserve((void **)&proto->code, &cap, proto->code_len, sizeof(uint32_t)) ||
+        !vec_reserve((void **)&proto->pos, &proto->code_cap, proto->code_len, sizeof(uint32_t))) {
+        compile_fail(c, pos, "out of memory");
+        return 0;
+    }
+    proto->code[proto->code_len] = word;
+    proto->pos[proto->code_len] = pos;
+    return proto->code_len++;
+}
+
+static void emit_op(Compiler *c, Opcode op, int stack_effect, uint32_t pos) {
+    emit(c, op, pos);
+    c->depth += stack_effect;
+    if (c->depth > c->proto->max_stack) c->proto->max_stack = c->depth;
+}
+
+static uint32_t add_const(Compiler *c, Goon_Value *val, uint32_t pos) {
+    Proto *proto = c->proto;
+    if (!val || !vec_reserve((void **)&proto->consts, &proto->const_cap, proto->const_count, sizeof(Goon_Value *))) {
+        compile_fail(c, pos, "out of memory");
+        return 0;
+    }
+    proto->consts[proto->const_count] = val;
+    return (uint32_t)proto->const_count++;
+}
+
+static uint32_t add_name(Compiler *c, const Goon_Symbol *sym, uint32_t pos) {
+    Proto *proto = c->proto;
+    for (size_t i = 0; i < proto->name_count; i++) {
+        if (proto->names[i] == sym) return (uint32_t)i;
+    }
+    if (!vec_reserve((void **)&proto->names, &proto->name_cap, proto->name_count, sizeof(Goon_Symbol *))) {
+        compile_fail(c, pos, "out of memory");
+        return 0;
+    }
+    proto->names[proto->name_count] = sym;
+    return (uint32_t)proto->name_count++;
+}
+
+static uint32_t add_local(Compiler *c, const Goon_Symbol *sym, uint32_t pos) {
+    Proto *proto = c->proto;
+    if (!vec_reserve((void **)&proto->locals, &proto->local_cap, proto->local_count, sizeof(Goon_Symbol *))) {
+        compile_fail(c, pos, "out of memory");
+        return 0;
+    }
+    if (!vec_reserve((void **)&c->known, &c->known_cap, proto->local_count, sizeof(Goon_Value *))) {
+        compile_fail(c, pos, "out of memory");
+        return 0;
+    }
+    proto->locals[proto->local_count] = sym;
+    c->known[proto->local_count] = NULL;
+    return (uint32_t)proto->local_count++;
+}
+
+static int find_local(Compiler *c, const Goon_Symbol *sym) {
+    for (size_t i = c->proto->local_count; i > 0; i--) {
+        if (c->proto->locals[i - 1] == sym) return (int)(i - 1);
+    }
+    return -1;
+}
+
+static int find_capture(Compiler *c, const Goon_Symbol *sym, uint32_t pos) {
+    Proto *proto = c->proto;
+    for (size_t i = 0; i < proto->capture_count; i++) {
+        if (proto->captures[i].name == sym) return (int)i;
+    }
+    if (!c->parent) return -1;
+
+    bool from_local = true;
+    int index = find_local(c->parent, sym);
+    if (index < 0) {
+        from_local = false;
+        index = find_capture(c->parent, sym, pos);
+        if (index < 0) return -1;
+    }
+
+    if (!vec_reserve((void **)&proto->captures, &proto->capture_cap, proto->capture_count, sizeof(Capture))) {
+        compile_fail(c, pos, "out of memory");
+        return -1;
+    }
+    Capture *cap = &proto->captures[proto->capture_count];
+    cap->name = sym;
+    cap->from_local = from_local;
+    cap->index = (uint32_t)index;
+    return (int)proto->capture_count++;
+}
+
+static void emit_load(Compiler *c, const Goon_Symbol *sym, uint32_t pos) {
+    int index = find_local(c, sym);
+    if (index >= 0) {
+        emit_op(c, OP_LOAD_LOCAL, 1, pos);
+        emit(c, (uint32_t)index, pos);
+        return;
+    }
+    index = find_capture(c, sym, pos);
+    if (index >= 0) {
+        emit_op(c, OP_LOAD_CAPTURE, 1, pos);
+        emit(c, (uint32_t)index, pos);
+        return;
+    }
+    emit_op(c, OP_LOAD_GLOBAL, 1, pos);
+    emit(c, add_name(c, sym, pos), pos);
+}
+
+static void emit_const(Compiler *c, Goon_Value *val, uint32_t pos) {
+    uint32_t k = add_const(c, val, pos);
+    emit_op(c, OP_CONST, 1, pos);
+    emit(c, k, pos);
+}
+
+static void emit_name_op(Compiler *c, Opcode op, int stack_effect, const Goon_Symbol *sym, uint32_t pos) {
+    uint32_t n = add_name(c, sym, pos);
+    emit_op(c, op, stack_effect, pos);
+    emit(c, n, pos);
+}
+
+static void emit_field_op(Compiler *c, Opcode op, int stack_effect, const Goon_Symbol *sym, uint32_t pos) {
+    Proto *proto = c->proto;
+    emit_name_op(c, op, stack_effect, sym, pos);
+    if (!vec_reserve((void **)&proto->caches, &proto->cache_cap, proto->cache_count, sizeof(Goon_Field_Cache))) {
+        compile_fail(c, pos, "out of memory");
+        return;
+    }
+    memset(&proto->caches[proto->cache_count], 0, sizeof(Goon_Field_Cache));
+    emit(c, (uint32_t)proto->cache_count++, pos);
+}
+
+static void patch_jump(Compiler *c, size_t at) {
+    c->proto->code[at] = (uint32_t)c->proto->code_len;
+}
+
+static Goon_Value *string_const(Compiler *c, const char *ptr, size_t len, bool terminated) {
+    if (terminated || c->src->borrowed) return goon_string_len(c->ctx, ptr, len);
+    return string_value(c->ctx, ptr, len, false);
+}
+
+static size_t format_int(char *buf, int64_t i) {
+    char tmp[24];
+    size_t n = 0;
+    uint64_t u = i < 0 ? 0 - (uint64_t)i : (uint64_t)i;
+    do {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    size_t len = 0;
+    if (i < 0) buf[len++] = '-';
+    while (n) buf[len++] = tmp[--n];
+    return len;
+}
+
+static size_t interp_text(Goon_Value *val, char *num_buf, const char **out) {
+    switch (value_type(val)) {
+        case GOON_STRING:
+            *out = val->data.string.ptr;
+            return val->data.string.len;
+        case GOON_INT:
+            *out = num_buf;
+            return format_int(num_buf, int_value(val));
+        case GOON_BOOL:
+            *out = val == VALUE_TRUE ? "true" : "false";
+            return val == VALUE_TRUE ? 4 : 5;
+        default:
+            *out = "";
+            return 0;
+    }
+}
+
+static void append_interpolated(String_Builder *sb, Goon_Value *val) {
+    char num_buf[24];
+    const char *text;
+    size_t len = interp_text(val, num_buf, &text);
+    sb_append_len(sb, text, len);
+}
+
+#define FOLD_LIST_MAX 256
+
+typedef struct Fold_Env {
+    const Goon_Symbol *name;
+    Goon_Value *value;
+    struct Fold_Env *next;
+} Fold_Env;
+
+static Goon_Value *freeze(Goon_Value *val) {
+    if (!is_heap(val) || val->frozen) return val;
+    val->frozen = true;
+    if (val->type == GOON_LIST) {
+        for (size_t i = 0; i < val->data.list.len; i++) {
+            freeze(val->data.list.items[i]);
+        }
+    } else if (val->type == GOON_RECORD) {
+        for (uint32_t i = 0; i < val->data.record.shape->count; i++) {
+            freeze(val->data.record.values[i]);
+        }
+        freeze(val->data.record.parent);
+    }
+    return val;
+}
+
+static Goon_Value *fold_lookup(Compiler *c, Fold_Env *env, const Goon_Symbol *sym) {
+    for (; env; env = env->next) {
+        if (env->name == sym) return env->value;
+    }
+    for (; c; c = c->parent) {
+        int slot = find_local(c, sym);
+        if (slot >= 0) return c->known[slot];
+    }
+    return NULL;
+}
+
+static bool is_builtin(Compiler *c, Fold_Env *env, const Goon_Symbol *sym, Goon_Builtin_Fn fn) {
+    for (; env; env = env->next) {
+        if (env->name == sym) return false;
+    }
+    for (Compiler *scope = c; scope; scope = scope->parent) {
+        if (find_local(scope, sym) >= 0) return false;
+    }
+    Goon_Value *val = lookup_global(c->ctx, sym);
+    return value_type(val) == GOON_BUILTIN && val->data.builtin == fn;
+}
+
+static Goon_Value *fold(Compiler *c, Node *n, Fold_Env *env);
+
+static Goon_Value *fold_map(Compiler *c, Node *n, Fold_Env *env) {
+    if (n->data.call.argc != 2 || !is_builtin(c, env, n->data.call.name, builtin_map)) return NULL;
+    Node *fn = n->data.call.args[1];
+    if (fn->type != NODE_LAMBDA || fn->data.lambda.param_count != 1) return NULL;
+
+    Goon_Value *list = fold(c, n->data.call.args[0], env);
+    if (value_type(list) != GOON_LIST || list->data.list.len > FOLD_LIST_MAX) return NULL;
+
+    Goon_Value *result = goon_list(c->ctx);
+    if (!result) return NULL;
+    for (size_t i = 0; i < list->data.list.len; i++) {
+        Fold_Env param = { fn->data.lambda.params[0], list->data.list.items[i], env };
+        Goon_Value *mapped = fold(c, fn->data.lambda.body, &param);
+        if (!mapped) return NULL;
+        goon_list_push(c->ctx, result, mapped);
+    }
+    return result;
+}
+
+static Goon_Value *fold_call(Compiler *c, Node *n, Fold_Env *env) {
+    static const Goon_Builtin_Fn pure[] = { builtin_concat, builtin_zip, builtin_enumerate };
+    size_t argc = n->data.call.argc;
+    if (argc > 16) return NULL;
+
+    Goon_Builtin_Fn fn = NULL;
+    for (size_t i = 0; i < sizeof(pure) / sizeof(pure[0]) && !fn; i++) {
+        if (is_builtin(c, env, n->data.call.name, pure[i])) fn = pure[i];
+    }
+    if (!fn) return fold_map(c, n, env);
+
+    Goon_Value *args[16];
+    for (size_t i = 0; i < argc; i++) {
+        args[i] = fold(c, n->data.call.args[i], env);
+        if (!args[i] || goon_list_len(args[i]) > FOLD_LIST_MAX) return NULL;
+    }
+    return fn(c->ctx, args, argc);
+}
+
+static Goon_Value *fold_node(Compiler *c, Node *n, Fold_Env *env) {
+    Goon_Ctx *ctx = c->ctx;
+
+    switch (n->type) {
+        case NODE_INT:
+            return goon_int(ctx, n->data.integer);
+
+        case NODE_STRING:
+            return string_const(c, n->data.string.ptr, n->data.string.len, n->data.string.terminated);
+
+        case NODE_TRUE:
+        case NODE_FALSE:
+            return goon_bool(ctx, n->type == NODE_TRUE);
+
+        case NODE_VAR:
+            return fold_lookup(c, env, n->data.var);
+
+        case NODE_INTERP: {
+            for (size_t i = 0; i < n->data.interp.count; i++) {
+                Node *expr = n->data.interp.parts[i].expr;
+                if (expr && !fold(c, expr, env)) return NULL;
+            }
+            String_Builder sb;
+            sb_init(&sb);
+            for (size_t i = 0; i < n->data.interp.count; i++) {
+                Interp_Part *part = &n->data.interp.parts[i];
+                sb_append_len(&sb, part->text, part->len);
+                if (part->expr) append_interpolated(&sb, fold(c, part->expr, env));
+            }
+            if (!sb.buf) return NULL;
+            Goon_Value *str = goon_string_len(ctx, sb.buf, sb.len);
+            free(sb.buf);
+            return str;
+        }
+
+        case NODE_FIELD: {
+            Goon_Value *object = fold(c, n->data.field.object, env);
+            if (!object) return NULL;
+            Goon_Value *val = goon_record_get_sym(object, n->data.field.name);
+            return val ? val : goon_nil(ctx);
+        }
+
+        case NODE_RECORD: {
+            Goon_Value *record = goon_record(ctx);
+            if (!record) return NULL;
+            for (size_t i = 0; i < n->data.record.count; i++) {
+                Record_Item *item = &n->data.record.items[i];
+                Goon_Value *val = fold(c, item->value, env);
+                if (!val) return NULL;
+                if (item->path_len == 0) {
+                    if (value_type(val) != GOON_RECORD) continue;
+                    record_spread(ctx, record, val);
+                } else {
+                    goon_record_set_path(ctx, record, item->path, item->path_len, val);
+                }
+            }
+            return record;
+        }
+
+        case NODE_LIST: {
+            Goon_Value **parts = ctx_alloc(ctx, (n->data.list.count + 1) * sizeof(Goon_Value *));
+            if (!parts) return NULL;
+            size_t part_count = 0;
+            size_t view_parts = 0;
+            size_t total = 0;
+            size_t literal = 0;
+            Goon_Value *list = NULL;
+            for (size_t i = 0; i < n->data.list.count; i++) {
+                Node *item = n->data.list.items[i];
+                Goon_Value *val;
+                if (item->type == NODE_SPREAD || item->type == NODE_RANGE) {
+                    if (item->type == NODE_SPREAD) {
+                        val = fold(c, item->data.spread, env);
+                    } else {
+                        val = seq_range(ctx, item->data.range.start, item->data.range.end, 1);
+                    }
+                    if (!val) return NULL;
+                    parts[part_count++] = val;
+                    total += goon_list_len(val);
+                    view_parts += seq_is_view(val) ? val->data.seq.part_count : 1;
+                    list = NULL;
+                    continue;
+                }
+                if (++literal > FOLD_LIST_MAX) return NULL;
+                if (!list) {
+                    list = goon_list(ctx);
+                    if (!list) return NULL;
+                    parts[part_count++] = list;
+                    view_parts++;
+                }
+                val = fold(c, item, env);
+                if (!val) return NULL;
+                goon_list_push(ctx, list, val);
+                total++;
+            }
+            if (part_count == 0) return goon_list(ctx);
+            if (part_count == 1 && (list || n->data.list.items[0]->type == NODE_RANGE)) return parts[0];
+            if (total > FOLD_LIST_MAX && view_parts > LIST_MAX_PARTS) return NULL;
+            return list_join(ctx, parts, part_count);
+        }
+
+        case NODE_IF: {
+            Goon_Value *cond = fold(c, n->data.cond.cond, env);
+            if (!cond) return NULL;
+            return fold(c, goon_to_bool(cond) ? n->data.cond.then_branch : n->data.cond.else_branch, env);
+        }
+
+        case NODE_CALL:
+            return fold_call(c, n, env);
+
+        case NODE_RANGE:
+        case NODE_SPREAD:
+        case NODE_LAMBDA:
+        case NODE_LET:
+        case NODE_IMPORT:
+            break;
+    }
+    return NULL;
+}
+
+static Goon_Value *fold_checked(Compiler *c, Node *n, Fold_Env *env) {
+    Goon_Value *val = fold_node(c, n, env);
+    if (c->ctx->memory_exceeded) {
+        compile_fail(c, n->pos, "memory limit exceeded");
+        return NULL;
+    }
+    return freeze(val);
+}
+
+static Goon_Value *fold(Compiler *c, Node *n, Fold_Env *env) {
+    if (c->failed) return NULL;
+    if (env) return fold_checked(c, n, env);
+    if (n->fold == FOLD_UNKNOWN) {
+        n->folded = fold_checked(c, n, NULL);
+        n->fold = n->folded ? FOLD_CONST : FOLD_DYNAMIC;
+    }
+    return n->folded;
+}
+
+static void compile_node(Compiler *c, Node *n);
+
+static Proto *compile_function(Compiler *c, uint32_t pos, const Goon_Symbol **params, size_t param_count, Node *body) {
+    Proto *proto = proto_create(c, pos);
+    if (!proto) {
+        compile_fail(c, pos, "out of memory");
+        return NULL;
+    }
+
+    Compiler inner = *c;
+    inner.proto = proto;
+    inner.parent = c;
+    inner.known = NULL;
+    inner.known_cap = 0;
+    inner.branch_depth = 0;
+    inner.depth = 0;
+
+    for (size_t i = 0; i < param_count; i++) {
+        add_local(&inner, params[i], pos);
+    }
+    proto->param_count = param_count;
+
+    compile_node(&inner, body);
+    emit_op(&inner, OP_RETURN, -1, pos);
+    free(inner.known);
+    c->failed = inner.failed;
+    return proto;
+}
+
+static void emit_function(Compiler *c, Opcode op, Proto *proto, uint32_t pos) {
+    if (!proto) return;
+    Proto *parent = c->proto;
+    if (!vec_reserve((void **)&parent->protos, &parent->proto_cap, parent->proto_count, sizeof(Proto *))) {
+        compile_fail(c, pos, "out of memory");
+        return;
+    }
+    parent->protos[parent->proto_count] = proto;
+    emit_op(c, op, 1, pos);
+    emit(c, (uint32_t)parent->proto_count++, pos);
+}
+
+static void compile_lazy(Compiler *c, Node *n) {
+    if (!c->ctx->lazy || fold(c, n, NULL)) {
+        compile_node(c, n);
+        return;
+    }
+    switch (n->type) {
+        case NODE_VAR:
+        case NODE_LAMBDA:
+        case NODE_LET:
+            compile_node(c, n);
+            return;
+        default:
+            break;
+    }
+    emit_function(c, OP_THUNK, compile_function(c, n->pos, NULL, 0, n), n->pos);
+}
+
+static void compile_node(Compiler *c, Node *n) {
+    if (c->failed) return;
+
+    Goon_Value *folded = fold(c, n, NULL);
+    if (folded) {
+        emit_const(c, folded, n->pos);
+        return;
+    }
+
+    switch (n->type) {
+        case NODE_INT:
+            emit_const(c, goon_int(c->ctx, n->data.integer), n->pos);
+            break;
+
+        case NODE_STRING:
+            emit_const(c, string_const(c, n->data.string.ptr, n->data.string.len, n->data.string.terminated), n->pos);
+            break;
+
+        case NODE_INTERP: {
+            uint32_t pieces = 0;
+            for (size_t i = 0; i < n->data.interp.count; i++) {
+                Interp_Part *part = &n->data.interp.parts[i];
+                if (part->len > 0) {
+                    emit_const(c, goon_string_len(c->ctx, part->text, part->len), n->pos);
+                    pieces++;
+                }
+                if (part->expr) {
+                    compile_node(c, part->expr);
+                    pieces++;
+                }
+            }
+            emit_op(c, OP_CONCAT, 1 - (int)pieces, n->pos);
+            emit(c, pieces, n->pos);
+            break;
+        }
+
+        case NODE_TRUE:
+        case NODE_FALSE:
+            emit_const(c, goon_bool(c->ctx, n->type == NODE_TRUE), n->pos);
+            break;
+
+        case NODE_VAR:
+            emit_load(c, n->data.var, n->pos);
+            break;
+
+        case NODE_FIELD:
+            compile_node(c, n->data.field.object);
+            emit_field_op(c, OP_GET_FIELD, 0, n->data.field.name, n->pos);
+            break;
+
+        case NODE_CALL:
+            emit_load(c, n->data.call.name, n->pos);
+            for (size_t i = 0; i < n->data.call.argc; i++) {
+                compile_node(c, n->data.call.args[i]);
+            }
+            emit_op(c, OP_CALL, -(int)n->data.call.argc, n->pos);
+            emit(c, (uint32_t)n->data.call.argc, n->pos);
+            break;
+
+        case NODE_RECORD: {
+            uint32_t fields = 0;
+            for (size_t i = 0; i < n->data.record.count; i++) {
+                if (n->data.record.items[i].path_len > 0) fields++;
+            }
+            emit_op(c, OP_RECORD, 1, n->pos);
+            emit(c, fields, n->pos);
+            for (size_t i = 0; i < n->data.record.count; i++) {
+                Record_Item *item = &n->data.record.items[i];
+                compile_lazy(c, item->value);
+                if (item->path_len == 0) {
+                    emit_op(c, OP_SPREAD_RECORD, -1, item->value->pos);
+                } else if (item->path_len == 1) {
+                    emit_field_op(c, OP_SET_FIELD, -1, item->path[0], item->value->pos);
+                } else {
+                    emit_op(c, OP_SET_PATH, -1, item->value->pos);
+                    emit(c, (uint32_t)item->path_len, item->value->pos);
+                    for (size_t j = 0; j < item->path_len; j++) {
+                        emit(c, add_name(c, item->path[j], item->value->pos), item->value->pos);
+                    }
+                }
+            }
+            emit_op(c, OP_SEAL, 0, n->pos);
+            break;
+        }
+
+        case NODE_LIST: {
+            bool spread = false;
+            for (size_t i = 0; i < n->data.list.count; i++) {
+                Node_Type type = n->data.list.items[i]->type;
+                if (type == NODE_SPREAD || type == NODE_RANGE) spread = true;
+            }
+            if (!spread) emit_op(c, OP_LIST, 1, n->pos);
+            size_t parts = 0;
+            bool chunk = !spread;
+            for (size_t i = 0; i < n->data.list.count; i++) {
+                Node *item = n->data.list.items[i];
+                if (item->type == NODE_SPREAD || item->type == NODE_RANGE) {
+                    if (item->type == NODE_SPREAD) {
+                        compile_node(c, item->data.spread);
+                    } else {
+                        Goon_Value *range = seq_range(c->ctx, item->data.range.start, item->data.range.end, 1);
+                        if (!range) {
+                            compile_fail(c, item->pos, "out of memory");
+                            return;
+                        }
+                        emit_const(c, range, item->pos);
+                    }
+                    parts++;
+                    chunk = false;
+                    continue;
+                }
+                if (!chunk) {
+                    emit_op(c, OP_LIST, 1, item->pos);
+                    parts++;
+                    chunk = true;
+                }
+                compile_lazy(c, item);
+                emit_op(c, OP_APPEND, -1, item->pos);
+            }
+            if (spread) {
+                emit_op(c, OP_JOIN_LIST, 1 - (int)parts, n->pos);
+                emit(c, (uint32_t)parts, n->pos);
+            }
+            break;
+        }
+
+        case NODE_LAMBDA:
+            emit_function(c, OP_CLOSURE,
+                          compile_function(c, n->pos, n->data.lambda.params, n->data.lambda.param_count, n->data.lambda.body),
+                          n->pos);
+            break;
+
+        case NODE_IF: {
+            Goon_Value *cond = fold(c, n->data.cond.cond, NULL);
+            if (cond) {
+                compile_node(c, goon_to_bool(cond) ? n->data.cond.then_branch : n->data.cond.else_branch);
+                break;
+            }
+            compile_node(c, n->data.cond.cond);
+            emit_op(c, OP_JUMP_IF_FALSE, -1, n->pos);
+            size_t else_jump = emit(c, 0, n->pos);
+            c->branch_depth++;
+            compile_node(c, n->data.cond.then_branch);
+            emit_op(c, OP_JUMP, -1, n->pos);
+            size_t end_jump = emit(c, 0, n->pos);
+            patch_jump(c, else_jump);
+            compile_node(c, n->data.cond.else_branch);
+            c->branch_depth--;
+            patch_jump(c, end_jump);
+            break;
+        }
+
+        case NODE_LET: {
+            compile_lazy(c, n->data.let.value);
+            uint32_t slot = add_local(c, n->data.let.name, n->pos);
+            if (c->branch_depth == 0 && !c->failed) c->known[slot] = fold(c, n->data.let.value, NULL);
+            emit_op(c, OP_STORE_LOCAL, 0, n->pos);
+            emit(c, slot, n->pos);
+            break;
+        }
+
+        case NODE_IMPORT:
+            emit_op(c, OP_IMPORT, 1, n->pos);
+            emit(c, add_const(c, goon_string(c->ctx, n->data.import_path), n->pos), n->pos);
+            break;
+
+        case NODE_RANGE:
+        case NODE_SPREAD:
+            compile_fail(c, n->pos, "unexpected expression");
+            break;
+    }
+}
+
+static Proto *compile_program(Goon_Ctx *ctx, Goon_Source *src) {
+    Compiler c;
+    c.ctx = ctx;
+    c.src = src;
+    c.parent = NULL;
+    c.known = NULL;
+    c.known_cap = 0;
+    c.branch_depth = 0;
+    c.depth = 0;
+    c.failed = false;
+    c.proto = proto_create(&c, 0);
+    if (!c.proto) {
+        set_error(ctx, src, 0, "out of memory");
+        return NULL;
+    }
+
+    if (src->expr_count == 0) {
+        emit_op(&c, OP_NIL, 1, 0);
+    }
+    for (size_t i = 0; i < src->expr_count; i++) {
+        if (i > 0) emit_op(&c, OP_POP, -1, src->exprs[i]->pos);
+        compile_node(&c, src->exprs[i]);
+    }
+    emit_op(&c, OP_RETURN, -1, (uint32_t)src->len);
+    free(c.known);
+
+    return c.failed ? NULL : c.proto;
+}
+
+typedef struct {
+    Goon_Value *fn;
+    Goon_Value **args;
+    size_t argc;
+    uint64_t hash;
+    Goon_Value *result;
+} Memo_Entry;
+
+struct Goon_Memo {
+    Memo_Entry *entries;
+    size_t mask;
+    Goon_Memo_Stats stats;
+};
+
+static void memo_free(Goon_Memo *memo) {
+    if (!memo) return;
+    for (size_t i = 0; i <= memo->mask; i++) {
+        free(memo->entries[i].args);
+    }
+    free(memo->entries);
+    free(memo);
+}
+
+static uint64_t memo_hash(Goon_Value *fn, Goon_Value **args, size_t argc) {
+    uint64_t h = (uint64_t)(uintptr_t)fn * 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < argc; i++) {
+        Goon_Value *arg = args[i];
+        uint64_t part;
+        switch (value_type(arg)) {
+            case GOON_STRING:
+                part = hash_bytes(arg->data.string.ptr, arg->data.string.len);
+                break;
+            case GOON_INT:
+                part = (uint64_t)int_value(arg);
+                break;
+            default:
+                part = (uint64_t)(uintptr_t)arg;
+                break;
+        }
+        h = (h ^ part) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+static bool memo_arg_equal(Goon_Value *a, Goon_Value *b) {
+    if (a == b) return true;
+    Goon_Type type = value_type(a);
+    if (type != value_type(b)) return false;
+    if (type == GOON_INT) return int_value(a) == int_value(b);
+    if (type == GOON_STRING) {
+        return a->data.string.len == b->data.string.len &&
+               memcmp(a->data.string.ptr, b->data.string.ptr, a->data.string.len) == 0;
+    }
+    return false;
+}
+
+static Goon_Value *memo_find(Goon_Memo *memo, Goon_Value *fn, Goon_Value **args, size_t argc, uint64_t hash) {
+    Memo_Entry *e = &memo->entries[hash & memo->mask];
+    if (e->fn == fn && e->hash == hash && e->argc == argc) {
+        size_t i = 0;
+        while (i < argc && memo_arg_equal(e->args[i], args[i])) i++;
+        if (i == argc) {
+            memo->stats.hits++;
+            return e->result;
+        }
+    }
+    memo->stats.misses++;
+    return NULL;
+}
+
+static void memo_store(Goon_Memo *memo, Goon_Value *fn, Goon_Value **args, size_t argc, uint64_t hash, Goon_Value *result) {
+    Memo_Entry *e = &memo->entries[hash & memo->mask];
+    Goon_Value **copy = NULL;
+    if (argc > 0) {
+        copy = malloc(argc * sizeof(Goon_Value *));
+        if (!copy) return;
+        memcpy(copy, args, argc * sizeof(Goon_Value *));
+    }
+    if (e->fn) {
+        memo->stats.evictions++;
+        free(e->args);
+    } else {
+        memo->stats.entries++;
+    }
+    e->fn = fn;
+    e->args = copy;
+    e->argc = argc;
+    e->hash = hash;
+    e->result = freeze(result);
+}
+
+typedef struct {
+    Proto *proto;
+    Goon_Value **captures;
+    Goon_Value *memo_fn;
+    uint64_t memo_hash;
+    size_t pc;
+    size_t base;
+} Frame;
+
+struct Goon_Vm {
+    Goon_Value **stack;
+    size_t stack_cap;
+    size_t sp;
+    Frame *frames;
+    size_t frame_count;
+    size_t frame_cap;
+};
+
+#define VM_MAX_FRAMES 4096
+
+static Goon_Vm *vm_create(void) {
+    return calloc(1, sizeof(Goon_Vm));
+}
+
+static void vm_destroy(Goon_Vm *vm) {
+    if (!vm) return;
+    free(vm->stack);
+    free(vm->frames);
+    free(vm);
+}
+
+static void vm_error(Goon_Ctx *ctx, Frame *frame, const char *msg) {
+    uint32_t pos = frame->pc > 0 ? frame->proto->pos[frame->pc - 1] : frame->proto->def_pos;
+    set_error(ctx, frame->proto->src, pos, msg);
+}
+
+static bool vm_push_frame(Goon_Ctx *ctx, Proto *proto, Goon_Value **captures, size_t base) {
+    Goon_Vm *vm = ctx->vm;
+    if (vm->frame_count >= VM_MAX_FRAMES) {
+        if (vm->frame_count > 0) vm_error(ctx, &vm->frames[vm->frame_count - 1], "call stack overflow");
+        return false;
+    }
+    size_t top = base + proto->local_count + proto->max_stack + 1;
+    if (!vec_reserve((void **)&vm->stack, &vm->stack_cap, top, sizeof(Goon_Value *)) ||
+        !vec_reserve((void **)&vm->frames, &vm->frame_cap, vm->frame_count, sizeof(Frame))) {
+        set_error(ctx, NULL, 0, "out of memory");
+        return false;
+    }
+    for (size_t i = proto->param_count; i < proto->local_count; i++) {
+        vm->stack[base + i] = NULL;
+    }
+    Frame *frame = &vm->frames[vm->frame_count++];
+    frame->proto = proto;
+    frame->captures = captures;
+    frame->pc = 0;
+    frame->base = base;
+    frame->memo_fn = NULL;
+    vm->sp = base + proto->local_count;
+    return true;
+}
+
+static Goon_Source *load_source(Goon_Ctx *ctx, const char *name, char *text, size_t len, bool mapped, bool borrowed, Lexer *lexed);
+static char *read_file(const char *path, size_t *out_len, bool *mapped);
+static void text_free(char *text, size_t len, bool mapped);
+static Goon_Value *vm_execute(Goon_Ctx *ctx, size_t entry);
+
+#define MAP_CHUNK 1024
+
+typedef struct {
+    Goon_Value *fn;
+    Goon_Value **items;
+    Goon_Value **out;
+    size_t len;
+    size_t next;
+    size_t failed;
+    Goon_Ctx *failed_worker;
+} Map_Job;
+
+struct Goon_Pool {
+    pthread_mutex_t lock;
+    pthread_mutex_t source_lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    pthread_t *threads;
+    Goon_Ctx **workers;
+    size_t count;
+    size_t started;
+    size_t busy;
+    size_t generation;
+    Map_Job *job;
+    bool stop;
+};
+
+static Goon_Value *run_proto(Goon_Ctx *ctx, Proto *proto) {
+    Goon_Vm *vm = ctx->vm;
+    size_t entry = vm->frame_count;
+    if (!vec_reserve((void **)&vm->stack, &vm->stack_cap, vm->sp, sizeof(Goon_Value *))) {
+        set_error(ctx, NULL, 0, "out of memory");
+        return NULL;
+    }
+    vm->stack[vm->sp++] = NULL;
+    if (!vm_push_frame(ctx, proto, NULL, vm->sp)) {
+        vm->sp--;
+        return NULL;
+    }
+    return vm_execute(ctx, entry);
+}
+
+static Goon_Module *module_entry(Goon_Ctx *ctx, const char *path, const struct stat *st) {
+    for (Goon_Module *m = ctx->modules; m; m = m->next) {
+        if (strcmp(m->path, path) == 0) return m;
+    }
+    Goon_Module *m = calloc(1, sizeof(Goon_Module));
+    if (!m) return NULL;
+    m->path = strdup(path);
+    if (!m->path) {
+        free(m);
+        return NULL;
     }
-
-    goon_record_set_path(ctx, intermediate, path + 1, path_len - 1, value);
+    m->dev = st->st_dev;
+    m->ino = st->st_ino;
+    m->mtime = st->st_mtime;
+    m->size = st->st_size;
+    m->next = ctx->modules;
+    ctx->modules = m;
+    return m;
 }
 
-Goon_Record_Field *goon_record_fields(Goon_Value *record) {
-    if (!record || record->type != GOON_RECORD) return NULL;
-    return record->data.record.fields;
+static bool module_same(const Goon_Module *m, const struct stat *st) {
+    return m->dev == st->st_dev && m->ino == st->st_ino &&
+           m->mtime == st->st_mtime && m->size == st->st_size;
 }
 
-static Goon_Value *lookup(Goon_Ctx *ctx, const char *name) {
-    Goon_Binding *b = ctx->env;
-    while (b) {
-        if (strcmp(b->name, name) == 0) {
-            return b->value;
+struct Goon_Import {
+    Goon_Module *module;
+    Goon_Import *next;
+};
+
+static bool module_loading(Goon_Ctx *ctx, Goon_Module *module) {
+    for (; ctx; ctx = ctx->parent) {
+        for (Goon_Import *import = ctx->imports; import; import = import->next) {
+            if (import->module == module) return true;
         }
-        b = b->next;
     }
-    return NULL;
+    return false;
 }
 
-static void define(Goon_Ctx *ctx, const char *name, Goon_Value *value) {
-    Goon_Binding *b = ctx->env;
-    while (b) {
-        if (strcmp(b->name, name) == 0) {
-            b->value = value;
-            return;
-        }
-        b = b->next;
+static Goon_Module *module_owner(Goon_Ctx *ctx) {
+    Goon_Vm *vm = ctx->vm;
+    for (size_t i = vm->frame_count; i > 0; i--) {
+        Frame *frame = &vm->frames[i - 1];
+        Goon_Value *callee = vm->stack[frame->base - 1];
+        if (!callee || value_type(callee) == GOON_THUNK) return frame->proto->src->module;
     }
-    b = malloc(sizeof(Goon_Binding));
-    if (!b) return;
-    b->name = strdup(name);
-    b->value = value;
-    b->next = ctx->env;
-    ctx->env = b;
+    return NULL;
 }
 
-typedef struct {
-    Goon_Ctx *ctx;
-    Lexer *lex;
-} Parser;
-
-static Goon_Value *parse_expr(Parser *p);
-
-static Goon_Value *call_lambda(Goon_Ctx *ctx, Goon_Value *fn, Goon_Value **args, size_t argc) {
-    if (!fn || fn->type != GOON_LAMBDA) return goon_nil(ctx);
-    if (argc != fn->data.lambda.param_count) return goon_nil(ctx);
-
-    Goon_Binding *old_env = ctx->env;
-    ctx->env = fn->data.lambda.env;
-
-    for (size_t i = 0; i < argc; i++) {
-        define(ctx, fn->data.lambda.params[i], args[i]);
+static bool module_reaches(Goon_Module *from, Goon_Module *to) {
+    if (from == to) return true;
+    if (from->visited) return false;
+    from->visited = true;
+    for (size_t i = 0; i < from->dep_count; i++) {
+        if (module_reaches(from->deps[i], to)) return true;
     }
+    return false;
+}
 
-    Lexer body_lex;
-    lexer_init(&body_lex, fn->data.lambda.body);
-    Parser body_parser;
-    body_parser.ctx = ctx;
-    body_parser.lex = &body_lex;
-
-    if (!lexer_next(&body_lex)) {
-        ctx->env = old_env;
-        return goon_nil(ctx);
+static bool module_depend(Goon_Ctx *ctx, Goon_Module *from, Goon_Module *to) {
+    for (size_t i = 0; i < from->dep_count; i++) {
+        if (from->deps[i] == to) return true;
     }
-
-    Goon_Value *result = parse_expr(&body_parser);
-
-    ctx->env = old_env;
-    return result ? result : goon_nil(ctx);
+    for (Goon_Module *m = ctx->modules; m; m = m->next) m->visited = false;
+    if (module_reaches(to, from)) return false;
+    if (vec_reserve((void **)&from->deps, &from->dep_cap, from->dep_count, sizeof(Goon_Module *))) {
+        from->deps[from->dep_count++] = to;
+    }
+    return true;
 }
 
-static Goon_Value *builtin_map(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
-    if (argc != 2) return goon_nil(ctx);
-    Goon_Value *list = args[0];
-    Goon_Value *fn = args[1];
-
-    if (!list || list->type != GOON_LIST) return goon_nil(ctx);
-    if (!fn || (fn->type != GOON_LAMBDA && fn->type != GOON_BUILTIN)) return goon_nil(ctx);
+static void modules_free(Goon_Module *m) {
+    while (m) {
+        Goon_Module *next = m->next;
+        free(m->path);
+        free(m->deps);
+        free(m);
+        m = next;
+    }
+}
 
-    Goon_Value *result = goon_list(ctx);
+static void import_path(char *out, size_t size, const char *base, const char *path) {
+    if (base && path[0] != '/') {
+        char *base_copy = strdup(base);
+        char *dir = base_copy ? dirname(base_copy) : ".";
+        snprintf(out, size, "%s/%s", dir, path);
+        free(base_copy);
+    } else {
+        snprintf(out, size, "%s", path);
+    }
 
-    for (size_t i = 0; i < list->data.list.len; i++) {
-        Goon_Value *item = list->data.list.items[i];
-        Goon_Value *mapped;
+    size_t len = strlen(out);
+    if (len < 5 || strcmp(out + len - 5, ".goon") != 0) {
+        strncat(out, ".goon", size - len - 1);
+    }
+}
 
-        if (fn->type == GOON_LAMBDA) {
-            Goon_Value *fn_args[1] = { item };
-            mapped = call_lambda(ctx, fn, fn_args, 1);
-        } else {
-            Goon_Value *fn_args[1] = { item };
-            mapped = fn->data.builtin(ctx, fn_args, 1);
-        }
+typedef struct Prefetch_File {
+    char *path;
+    char *text;
+    size_t len;
+    bool mapped;
+    Lexer lex;
+    bool done;
+    struct Prefetch_File *next;
+} Prefetch_File;
+
+struct Goon_Prefetch {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t ready;
+    pthread_t *threads;
+    size_t count;
+    Prefetch_File *files;
+    char **queue;
+    size_t queue_len;
+    size_t queue_cap;
+    bool stop;
+};
+
+static Prefetch_File *prefetch_find(Goon_Prefetch *pf, const char *path) {
+    for (Prefetch_File *file = pf->files; file; file = file->next) {
+        if (strcmp(file->path, path) == 0) return file;
+    }
+    return NULL;
+}
 
-        goon_list_push(ctx, result, mapped);
+static Prefetch_File *prefetch_add(Goon_Prefetch *pf, char *path) {
+    Prefetch_File *file = calloc(1, sizeof(Prefetch_File));
+    if (!file) {
+        free(path);
+        return NULL;
     }
+    file->path = path;
+    file->next = pf->files;
+    pf->files = file;
+    return file;
+}
 
-    return result;
+static void prefetch_push(Goon_Prefetch *pf, const char *base, const char *path, size_t len) {
+    char rel[512];
+    char full[1024];
+    memcpy(rel, path, len);
+    rel[len] = '\0';
+    import_path(full, sizeof(full), base, rel);
+    char *copy = strdup(full);
+    pthread_mutex_lock(&pf->lock);
+    if (copy && vec_reserve((void **)&pf->queue, &pf->queue_cap, pf->queue_len, sizeof(char *))) {
+        pf->queue[pf->queue_len++] = copy;
+        pthread_cond_signal(&pf->wake);
+    } else {
+        free(copy);
+    }
+    pthread_mutex_unlock(&pf->lock);
 }
 
-static Goon_Value *interpolate_string(Goon_Ctx *ctx, const char *str) {
-    size_t len = strlen(str);
-    size_t buf_size = len * 2 + 1;
-    char *buf = malloc(buf_size);
-    if (!buf) return goon_string(ctx, str);
+static size_t prefetch_import(Goon_Prefetch *pf, const char *base, const char *text, size_t pos, size_t len) {
+    pos = scan_whitespace(text, pos, len);
+    if (pos >= len || text[pos] != '(') return pos;
+    size_t quote = scan_whitespace(text, pos + 1, len);
+    if (quote >= len || text[quote] != '"') return quote;
+    size_t end = scan_string(text, quote + 1, len);
+    if (end >= len || text[end] != '"' || end - quote - 1 >= 512) return quote;
+    prefetch_push(pf, base, text + quote + 1, end - quote - 1);
+    return end + 1;
+}
 
-    size_t buf_len = 0;
+static void prefetch_scan(Goon_Prefetch *pf, const char *base, const char *text, size_t len) {
     size_t i = 0;
-
     while (i < len) {
-        if (str[i] == '$' && i + 1 < len && str[i + 1] == '{') {
-            i += 2;
-            size_t var_start = i;
-            while (i < len && str[i] != '}') {
-                i++;
+        char c = text[i];
+        if (c == '/' && i + 1 < len && text[i + 1] == '/') {
+            const char *nl = memchr(text + i + 2, '\n', len - i - 2);
+            i = nl ? (size_t)(nl - text) : len;
+        } else if (c == '/' && i + 1 < len && text[i + 1] == '*') {
+            i = scan_comment_end(text, i + 2, len);
+            if (i == SIZE_MAX) return;
+        } else if (c == '"') {
+            for (i = scan_string(text, i + 1, len); i < len && text[i] != '"'; i = scan_string(text, i, len)) {
+                i += text[i] == '\\' ? 2 : 1;
             }
-            if (i < len) {
-                char *var_name = strdup_range(str + var_start, i - var_start);
-                Goon_Value *val = lookup(ctx, var_name);
-                free(var_name);
-
-                if (val) {
-                    const char *insert = NULL;
-                    char num_buf[32];
-                    if (val->type == GOON_STRING) {
-                        insert = val->data.string;
-                    } else if (val->type == GOON_INT) {
-                        snprintf(num_buf, sizeof(num_buf), "%ld", val->data.integer);
-                        insert = num_buf;
-                    } else if (val->type == GOON_BOOL) {
-                        insert = val->data.boolean ? "true" : "false";
-                    }
-                    if (insert) {
-                        size_t insert_len = strlen(insert);
-                        while (buf_len + insert_len >= buf_size) {
-                            buf_size *= 2;
-                            buf = realloc(buf, buf_size);
-                        }
-                        memcpy(buf + buf_len, insert, insert_len);
-                        buf_len += insert_len;
-                    }
-                }
-                i++;
+            i++;
+        } else if (char_is(c, CC_ALPHA)) {
+            size_t end = scan_ident(text, i, len);
+            if (end - i == 6 && memcmp(text + i, "import", 6) == 0) {
+                end = prefetch_import(pf, base, text, end, len);
             }
+            i = end;
         } else {
-            if (buf_len + 1 >= buf_size) {
-                buf_size *= 2;
-                buf = realloc(buf, buf_size);
-            }
-            buf[buf_len++] = str[i++];
+            i++;
         }
     }
-
-    buf[buf_len] = '\0';
-    Goon_Value *result = goon_string(ctx, buf);
-    free(buf);
-    return result;
 }
 
-static Goon_Value *parse_record(Parser *p) {
-    Goon_Value *record = goon_record(p->ctx);
-
-    if (!lexer_next(p->lex)) return NULL;
-
-    while (p->lex->current.type != TOK_RBRACE && p->lex->current.type != TOK_EOF) {
-        if (p->lex->current.type == TOK_SPREAD) {
-            if (!lexer_next(p->lex)) return NULL;
-            Goon_Value *spread_val = parse_expr(p);
-            if (spread_val && spread_val->type == GOON_RECORD) {
-                Goon_Record_Field *f = spread_val->data.record.fields;
-                while (f) {
-                    goon_record_set(p->ctx, record, f->key, f->value);
-                    f = f->next;
-                }
-            }
-            if (p->lex->current.type == TOK_COMMA) {
-                if (!lexer_next(p->lex)) return NULL;
-            } else if (p->lex->current.type == TOK_SEMICOLON) {
-                if (!lexer_next(p->lex)) return NULL;
-            }
-            continue;
-        }
-
-        if (p->lex->current.type != TOK_IDENT) {
-            lexer_set_error(p->lex, "expected field name");
-            return NULL;
-        }
-
-        char *path[32];
-        size_t path_len = 0;
-
-        path[path_len++] = strdup(p->lex->current.data.string);
-        if (!lexer_next(p->lex)) { free(path[0]); return NULL; }
-
-        while (p->lex->current.type == TOK_DOT && path_len < 32) {
-            if (!lexer_next(p->lex)) {
-                for (size_t i = 0; i < path_len; i++) free(path[i]);
-                return NULL;
-            }
-            if (p->lex->current.type != TOK_IDENT) {
-                lexer_set_error(p->lex, "expected field name after .");
-                for (size_t i = 0; i < path_len; i++) free(path[i]);
-                return NULL;
-            }
-            path[path_len++] = strdup(p->lex->current.data.string);
-            if (!lexer_next(p->lex)) {
-                for (size_t i = 0; i < path_len; i++) free(path[i]);
-                return NULL;
-            }
+static void *prefetch_thread(void *arg) {
+    Goon_Prefetch *pf = arg;
+    pthread_mutex_lock(&pf->lock);
+    for (;;) {
+        while (!pf->stop && pf->queue_len == 0) pthread_cond_wait(&pf->wake, &pf->lock);
+        if (pf->stop) break;
+        char *full = pf->queue[--pf->queue_len];
+        pthread_mutex_unlock(&pf->lock);
+
+        char *real = realpath(full, NULL);
+        pthread_mutex_lock(&pf->lock);
+        Prefetch_File *file = NULL;
+        if (real && !prefetch_find(pf, real)) {
+            file = prefetch_add(pf, real);
+        } else {
+            free(real);
         }
-
-        if (p->lex->current.type == TOK_COLON) {
-            if (!lexer_next(p->lex)) {
-                for (size_t i = 0; i < path_len; i++) free(path[i]);
-                return NULL;
-            }
-            if (!lexer_next(p->lex)) {
-                for (size_t i = 0; i < path_len; i++) free(path[i]);
-                return NULL;
+        pthread_mutex_unlock(&pf->lock);
+
+        size_t len = 0;
+        bool mapped = false;
+        char *text = file ? read_file(full, &len, &mapped) : NULL;
+        if (text) {
+            prefetch_scan(pf, full, text, len);
+            if (len <= UINT32_MAX) {
+                lexer_init(&file->lex, text, len, NULL);
+                lexer_run(&file->lex);
             }
         }
-
-        if (p->lex->current.type != TOK_EQUALS) {
-            lexer_set_error(p->lex, "expected = after field name");
-            for (size_t i = 0; i < path_len; i++) free(path[i]);
-            return NULL;
-        }
-
-        if (!lexer_next(p->lex)) {
-            for (size_t i = 0; i < path_len; i++) free(path[i]);
-            return NULL;
-        }
-
-        Goon_Value *value = parse_expr(p);
-        if (!value) {
-            for (size_t i = 0; i < path_len; i++) free(path[i]);
-            return NULL;
-        }
-
-        goon_record_set_path(p->ctx, record, path, path_len, value);
-        for (size_t i = 0; i < path_len; i++) free(path[i]);
-
-        if (p->lex->current.type == TOK_SEMICOLON) {
-            if (!lexer_next(p->lex)) return NULL;
-        } else if (p->lex->current.type == TOK_COMMA) {
-            if (!lexer_next(p->lex)) return NULL;
+        free(full);
+
+        pthread_mutex_lock(&pf->lock);
+        if (file) {
+            file->text = text;
+            file->len = len;
+            file->mapped = mapped;
+            file->done = true;
+            pthread_cond_broadcast(&pf->ready);
         }
     }
+    pthread_mutex_unlock(&pf->lock);
+    return NULL;
+}
 
-    if (p->lex->current.type != TOK_RBRACE) {
-        lexer_set_error(p->lex, "expected }");
-        return NULL;
+static void prefetch_free(Goon_Prefetch *pf) {
+    if (!pf) return;
+    pthread_mutex_lock(&pf->lock);
+    pf->stop = true;
+    pthread_cond_broadcast(&pf->wake);
+    pthread_mutex_unlock(&pf->lock);
+    for (size_t i = 0; i < pf->count; i++) {
+        pthread_join(pf->threads[i], NULL);
     }
 
-    if (!lexer_next(p->lex)) return NULL;
-    return record;
+    for (size_t i = 0; i < pf->queue_len; i++) {
+        free(pf->queue[i]);
+    }
+    Prefetch_File *file = pf->files;
+    while (file) {
+        Prefetch_File *next = file->next;
+        if (file->text) text_free(file->text, file->len, file->mapped);
+        free(file->lex.tokens);
+        free(file->path);
+        free(file);
+        file = next;
+    }
+    pthread_mutex_destroy(&pf->lock);
+    pthread_cond_destroy(&pf->wake);
+    pthread_cond_destroy(&pf->ready);
+    free(pf->queue);
+    free(pf->threads);
+    free(pf);
 }
 
-static Goon_Value *parse_list(Parser *p) {
-    Goon_Value *list = goon_list(p->ctx);
-
-    if (!lexer_next(p->lex)) return NULL;
-
-    while (p->lex->current.type != TOK_RBRACKET && p->lex->current.type != TOK_EOF) {
-        if (p->lex->current.type == TOK_SPREAD) {
-            if (!lexer_next(p->lex)) return NULL;
-            Goon_Value *spread_val = parse_expr(p);
-            if (spread_val && spread_val->type == GOON_LIST) {
-                for (size_t i = 0; i < spread_val->data.list.len; i++) {
-                    goon_list_push(p->ctx, list, spread_val->data.list.items[i]);
-                }
-            }
-        } else if (p->lex->current.type == TOK_INT) {
-            int64_t start = p->lex->current.data.integer;
-            if (!lexer_next(p->lex)) return NULL;
-
-            if (p->lex->current.type == TOK_DOTDOT) {
-                if (!lexer_next(p->lex)) return NULL;
-                if (p->lex->current.type != TOK_INT) {
-                    lexer_set_error(p->lex, "expected integer after ..");
-                    return NULL;
-                }
-                int64_t end = p->lex->current.data.integer;
-                if (!lexer_next(p->lex)) return NULL;
-
-                for (int64_t i = start; i <= end; i++) {
-                    goon_list_push(p->ctx, list, goon_int(p->ctx, i));
-                }
-            } else {
-                goon_list_push(p->ctx, list, goon_int(p->ctx, start));
-            }
-        } else {
-            Goon_Value *item = parse_expr(p);
-            if (!item) return NULL;
-            goon_list_push(p->ctx, list, item);
-        }
-
-        if (p->lex->current.type == TOK_COMMA) {
-            if (!lexer_next(p->lex)) return NULL;
-        }
+static void prefetch_start(Goon_Ctx *ctx, const char *name, const char *text, size_t len) {
+    prefetch_free(ctx->prefetch);
+    ctx->prefetch = NULL;
+    if (!ctx->pool) return;
+
+    Goon_Prefetch *pf = calloc(1, sizeof(Goon_Prefetch));
+    if (!pf) return;
+    pthread_mutex_init(&pf->lock, NULL);
+    pthread_cond_init(&pf->wake, NULL);
+    pthread_cond_init(&pf->ready, NULL);
+    prefetch_scan(pf, name, text, len);
+    size_t count = ctx->pool->count - 1;
+    pf->threads = pf->queue_len ? calloc(count, sizeof(pthread_t)) : NULL;
+    if (!pf->threads) {
+        prefetch_free(pf);
+        return;
     }
-
-    if (p->lex->current.type != TOK_RBRACKET) {
-        lexer_set_error(p->lex, "expected ]");
-        return NULL;
+    for (size_t i = 0; i < count; i++) {
+        if (pthread_create(&pf->threads[i], NULL, prefetch_thread, pf) != 0) break;
+        pf->count++;
     }
-
-    if (!lexer_next(p->lex)) return NULL;
-    return list;
+    ctx->prefetch = pf;
 }
 
-static Goon_Value *parse_import(Parser *p) {
-    if (!lexer_next(p->lex)) return NULL;
-
-    if (p->lex->current.type != TOK_LPAREN) {
-        lexer_set_error(p->lex,"expected ( after import");
-        return NULL;
+static char *prefetch_take(Goon_Prefetch *pf, const char *real, size_t *len, bool *mapped, Lexer *lex) {
+    if (!pf) return NULL;
+    pthread_mutex_lock(&pf->lock);
+    Prefetch_File *file = prefetch_find(pf, real);
+    char *text = NULL;
+    if (!file) {
+        char *copy = strdup(real);
+        if (copy && (file = prefetch_add(pf, copy))) file->done = true;
+    } else {
+        while (!file->done) pthread_cond_wait(&pf->ready, &pf->lock);
+        text = file->text;
+        *len = file->len;
+        *mapped = file->mapped;
+        *lex = file->lex;
+        file->text = NULL;
+        file->lex.tokens = NULL;
     }
+    pthread_mutex_unlock(&pf->lock);
+    return text;
+}
 
-    if (!lexer_next(p->lex)) return NULL;
+static Goon_Value *run_import(Goon_Ctx *ctx, Frame *frame, const char *path) {
+    Goon_Source *src = frame->proto->src;
 
-    if (p->lex->current.type != TOK_STRING) {
-        lexer_set_error(p->lex,"expected string path in import");
+    char full_path[1024];
+    import_path(full_path, sizeof(full_path), src->name, path);
+
+    char *real = realpath(full_path, NULL);
+    struct stat st;
+    if (!real || stat(real, &st) != 0) {
+        free(real);
+        vm_error(ctx, frame, "could not open import file");
         return NULL;
     }
 
-    char *path = strdup(p->lex->current.data.string);
-    if (!lexer_next(p->lex)) { free(path); return NULL; }
-
-    if (p->lex->current.type != TOK_RPAREN) {
-        lexer_set_error(p->lex,"expected ) after import path");
-        free(path);
-        return NULL;
+    Goon_Ctx *home = home_ctx(ctx);
+    Goon_Pool *pool = ctx->parent ? ctx->pool : NULL;
+    if (pool) pthread_mutex_lock(&pool->source_lock);
+    Goon_Module *module = module_entry(home, real, &st);
+    Goon_Value *value = NULL;
+    bool cycle = false;
+    bool owner = false;
+    if (module) {
+        if (module->value && module_same(module, &st)) {
+            value = module->value;
+        } else {
+            cycle = module_loading(ctx, module);
+        }
+        Goon_Module *from = ctx->lazy ? module_owner(ctx) : NULL;
+        if (from && !module_depend(home, from, module)) cycle = true;
+    }
+    if (module && !cycle) {
+        if (value) {
+            ctx->stats.module_hits++;
+        } else {
+            ctx->stats.module_misses++;
+            if (!module->loader) {
+                module->dev = st.st_dev;
+                module->ino = st.st_ino;
+                module->mtime = st.st_mtime;
+                module->size = st.st_size;
+                module->value = NULL;
+                module->loader = ctx;
+                owner = true;
+            }
+        }
     }
+    if (pool) pthread_mutex_unlock(&pool->source_lock);
 
-    if (!lexer_next(p->lex)) { free(path); return NULL; }
+    if (!module || cycle || value) {
+        free(real);
+        if (!module) vm_error(ctx, frame, "out of memory");
+        if (cycle) vm_error(ctx, frame, "import cycle");
+        return cycle ? NULL : value;
+    }
 
-    char full_path[1024];
-    if (path[0] == '.' && p->ctx->base_path) {
-        char *base_copy = strdup(p->ctx->base_path);
-        char *dir = dirname(base_copy);
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir, path);
-        free(base_copy);
-    } else if (p->ctx->base_path && path[0] != '/') {
-        char *base_copy = strdup(p->ctx->base_path);
-        char *dir = dirname(base_copy);
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir, path);
-        free(base_copy);
+    size_t len;
+    bool mapped;
+    Lexer lex = { 0 };
+    char *text = prefetch_take(home->prefetch, real, &len, &mapped, &lex);
+    free(real);
+    if (!text) {
+        text = read_file(full_path, &len, &mapped);
+        if (text && home->prefetch) prefetch_scan(home->prefetch, full_path, text, len);
+    }
+    if (!text) {
+        vm_error(ctx, frame, "could not open import file");
     } else {
-        snprintf(full_path, sizeof(full_path), "%s", path);
+        if (pool) pthread_mutex_lock(&pool->source_lock);
+        Goon_Source *loaded = load_source(ctx, full_path, text, len, mapped, false, lex.src ? &lex : NULL);
+        if (loaded) loaded->module = module;
+        if (pool) pthread_mutex_unlock(&pool->source_lock);
+        if (loaded) {
+            Goon_Import import = { module, ctx->imports };
+            ctx->imports = &import;
+            value = run_proto(ctx, loaded->main);
+            ctx->imports = import.next;
+        }
     }
 
-    size_t plen = strlen(full_path);
-    if (plen < 5 || strcmp(full_path + plen - 5, ".goon") != 0) {
-        strncat(full_path, ".goon", sizeof(full_path) - plen - 1);
+    if (owner) {
+        if (pool) pthread_mutex_lock(&pool->source_lock);
+        module->value = value;
+        module->loader = NULL;
+        if (pool) pthread_mutex_unlock(&pool->source_lock);
     }
+    return value;
+}
 
-    free(path);
-
-    FILE *f = fopen(full_path, "r");
-    if (!f) {
-        lexer_set_error(p->lex,"could not open import file");
+static Goon_Value *call_proto(Goon_Ctx *ctx, Goon_Value *callee, Proto *proto, Goon_Value **captures, Goon_Value **args, size_t argc) {
+    Goon_Vm *vm = ctx->vm;
+    size_t entry = vm->frame_count;
+    if (!vec_reserve((void **)&vm->stack, &vm->stack_cap, vm->sp + argc + 1, sizeof(Goon_Value *))) {
+        set_error(ctx, NULL, 0, "out of memory");
         return NULL;
     }
 
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    size_t base = vm->sp + 1;
+    vm->stack[vm->sp] = callee;
+    if (argc > 0) memcpy(&vm->stack[base], args, argc * sizeof(Goon_Value *));
+    if (!vm_push_frame(ctx, proto, captures, base)) return NULL;
+    return vm_execute(ctx, entry);
+}
 
-    char *source = malloc(size + 1);
-    if (!source) {
-        fclose(f);
-        return NULL;
+static Goon_Value *call_value(Goon_Ctx *ctx, Goon_Value *fn, Goon_Value **args, size_t argc) {
+    Goon_Type type = value_type(fn);
+    if (type == GOON_BUILTIN) {
+        Goon_Value *result = fn->data.builtin(ctx, args, argc);
+        return result ? result : goon_nil(ctx);
     }
-
-    size_t read_size = fread(source, 1, size, f);
-    source[read_size] = '\0';
-    fclose(f);
-
-    char *old_base = p->ctx->base_path;
-    p->ctx->base_path = strdup(full_path);
-
-    Lexer import_lex;
-    lexer_init(&import_lex, source);
-    Parser import_parser;
-    import_parser.ctx = p->ctx;
-    import_parser.lex = &import_lex;
-
-    if (!lexer_next(&import_lex)) {
-        free(source);
-        free(p->ctx->base_path);
-        p->ctx->base_path = old_base;
-        return NULL;
+    if (type != GOON_LAMBDA || argc != fn->data.lambda.proto->param_count) {
+        return goon_nil(ctx);
     }
-
-    Goon_Value *result = NULL;
-    while (import_lex.current.type != TOK_EOF) {
-        result = parse_expr(&import_parser);
-        if (!result) break;
+    if (!ctx->memo) {
+        return call_proto(ctx, fn, fn->data.lambda.proto, fn->data.lambda.captures, args, argc);
     }
 
-    free(source);
-    free(p->ctx->base_path);
-    p->ctx->base_path = old_base;
-
+    uint64_t hash = memo_hash(fn, args, argc);
+    Goon_Value *result = memo_find(ctx->memo, fn, args, argc, hash);
+    if (result) return result;
+    result = call_proto(ctx, fn, fn->data.lambda.proto, fn->data.lambda.captures, args, argc);
+    if (result && !ctx->scratch_on) memo_store(ctx->memo, fn, args, argc, hash, result);
     return result;
 }
 
-static Goon_Value *parse_call(Parser *p, const char *name) {
-    Goon_Value *fn = lookup(p->ctx, name);
+static Goon_Value *force(Goon_Value *val) {
+    while (value_type(val) == GOON_THUNK) {
+        if (val->data.thunk.result) {
+            val = val->data.thunk.result;
+            continue;
+        }
 
-    if (!lexer_next(p->lex)) return NULL;
+        Goon_Ctx *ctx = val->data.thunk.ctx;
+        Proto *proto = val->data.thunk.proto;
+        if (!proto) {
+            set_error(ctx, NULL, 0, "cyclic evaluation");
+            return NULL;
+        }
+        val->data.thunk.proto = NULL;
+        bool paused = scratch_pause(ctx, val);
+        Goon_Value *result = call_proto(ctx, val, proto, val->data.thunk.captures, NULL, 0);
+        scratch_resume(ctx, paused);
+        if (!result) {
+            val->data.thunk.proto = proto;
+            return NULL;
+        }
+        val->data.thunk.result = result;
+        val->data.thunk.captures = NULL;
+    }
+    return val;
+}
 
-    Goon_Value *args[16];
-    size_t argc = 0;
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO
+#endif
+
+static Goon_Value *vm_execute(Goon_Ctx *ctx, size_t entry) {
+    Goon_Vm *vm = ctx->vm;
+    Frame *frame = &vm->frames[vm->frame_count - 1];
+    const uint32_t *code = frame->proto->code;
+    Goon_Value **consts = frame->proto->consts;
+    const Goon_Symbol **names = frame->proto->names;
+    Goon_Value **stack = vm->stack;
+    Goon_Value **slots = stack + frame->base;
+    size_t pc = 0;
+    size_t sp = vm->sp;
+
+#define PUSH(v) (stack[sp++] = (v))
+#define POP() (stack[--sp])
+#define TOP() (stack[sp - 1])
+#define SAVE_STATE() (frame->pc = pc, vm->sp = sp)
+#define LOAD_STATE() do { \
+        frame = &vm->frames[vm->frame_count - 1]; \
+        code = frame->proto->code; \
+        consts = frame->proto->consts; \
+        names = frame->proto->names; \
+        stack = vm->stack; \
+        slots = stack + frame->base; \
+        pc = frame->pc; \
+        sp = vm->sp; \
+    } while (0)
+#define FAIL(msg) do { SAVE_STATE(); vm_error(ctx, frame, msg); goto error; } while (0)
+#define CHECK_MEMORY() do { if (ctx->memory_exceeded) FAIL("memory limit exceeded"); } while (0)
+#define FORCE(v) do { \
+        if (value_type(v) == GOON_THUNK) { \
+            SAVE_STATE(); \
+            (v) = force(v); \
+            if (!(v)) goto error; \
+            LOAD_STATE(); \
+        } \
+    } while (0)
+
+#ifdef VM_COMPUTED_GOTO
+    static void *dispatch[OP_COUNT] = {
+        [OP_CONST] = &&L_OP_CONST,
+        [OP_NIL] = &&L_OP_NIL,
+        [OP_POP] = &&L_OP_POP,
+        [OP_LOAD_LOCAL] = &&L_OP_LOAD_LOCAL,
+        [OP_STORE_LOCAL] = &&L_OP_STORE_LOCAL,
+        [OP_LOAD_CAPTURE] = &&L_OP_LOAD_CAPTURE,
+        [OP_LOAD_GLOBAL] = &&L_OP_LOAD_GLOBAL,
+        [OP_GET_FIELD] = &&L_OP_GET_FIELD,
+        [OP_RECORD] = &&L_OP_RECORD,
+        [OP_SET_FIELD] = &&L_OP_SET_FIELD,
+        [OP_SET_PATH] = &&L_OP_SET_PATH,
+        [OP_SPREAD_RECORD] = &&L_OP_SPREAD_RECORD,
+        [OP_SEAL] = &&L_OP_SEAL,
+        [OP_LIST] = &&L_OP_LIST,
+        [OP_APPEND] = &&L_OP_APPEND,
+        [OP_JOIN_LIST] = &&L_OP_JOIN_LIST,
+        [OP_CONCAT] = &&L_OP_CONCAT,
+        [OP_CLOSURE] = &&L_OP_CLOSURE,
+        [OP_THUNK] = &&L_OP_THUNK,
+        [OP_CALL] = &&L_OP_CALL,
+        [OP_JUMP] = &&L_OP_JUMP,
+        [OP_JUMP_IF_FALSE] = &&L_OP_JUMP_IF_FALSE,
+        [OP_IMPORT] = &&L_OP_IMPORT,
+        [OP_RETURN] = &&L_OP_RETURN,
+    };
+#define VM_CASE(op) L_##op:
+#define VM_NEXT() goto *dispatch[code[pc++]]
+    VM_NEXT();
+#else
+#define VM_CASE(op) case op:
+#define VM_NEXT() continue
+    for (;;) switch ((Opcode)code[pc++]) {
+#endif
+
+    VM_CASE(OP_CONST) {
+        PUSH(consts[code[pc++]]);
+        VM_NEXT();
+    }
 
-    while (p->lex->current.type != TOK_RPAREN && p->lex->current.type != TOK_EOF && argc < 16) {
-        args[argc++] = parse_expr(p);
-        if (p->lex->current.type == TOK_COMMA) {
-            if (!lexer_next(p->lex)) return NULL;
-        }
+    VM_CASE(OP_NIL) {
+        PUSH(goon_nil(ctx));
+        VM_NEXT();
     }
 
-    if (p->lex->current.type != TOK_RPAREN) {
-        lexer_set_error(p->lex,"expected )");
-        return NULL;
+    VM_CASE(OP_POP) {
+        sp--;
+        VM_NEXT();
     }
 
-    if (!lexer_next(p->lex)) return NULL;
+    VM_CASE(OP_LOAD_LOCAL) {
+        Goon_Value *val = slots[code[pc++]];
+        PUSH(val ? val : goon_nil(ctx));
+        VM_NEXT();
+    }
 
-    if (fn && fn->type == GOON_BUILTIN) {
-        return fn->data.builtin(p->ctx, args, argc);
+    VM_CASE(OP_STORE_LOCAL) {
+        slots[code[pc++]] = TOP();
+        VM_NEXT();
     }
 
-    if (fn && fn->type == GOON_LAMBDA) {
-        if (argc != fn->data.lambda.param_count) {
-            lexer_set_error(p->lex, "wrong number of arguments");
-            return NULL;
-        }
+    VM_CASE(OP_LOAD_CAPTURE) {
+        Goon_Value *val = frame->captures[code[pc++]];
+        PUSH(val ? val : goon_nil(ctx));
+        VM_NEXT();
+    }
 
-        Goon_Binding *old_env = p->ctx->env;
-        p->ctx->env = fn->data.lambda.env;
+    VM_CASE(OP_LOAD_GLOBAL) {
+        Goon_Value *val = lookup_global(ctx, names[code[pc++]]);
+        PUSH(val ? val : goon_nil(ctx));
+        VM_NEXT();
+    }
 
-        for (size_t i = 0; i < argc; i++) {
-            define(p->ctx, fn->data.lambda.params[i], args[i]);
+    VM_CASE(OP_GET_FIELD) {
+        Goon_Value *object = TOP();
+        FORCE(object);
+        const Goon_Symbol *name = names[code[pc++]];
+        Goon_Value **slot = record_slot_cached(object, name, &frame->proto->caches[code[pc++]], !ctx->parent);
+        Goon_Value *val = slot ? *slot : NULL;
+        if (value_type(val) == GOON_THUNK) {
+            FORCE(val);
+            *slot = val;
         }
+        TOP() = val ? val : goon_nil(ctx);
+        VM_NEXT();
+    }
+
+    VM_CASE(OP_RECORD) {
+        Goon_Value *record = goon_record(ctx);
+        if (!record || !record_reserve(ctx, record, code[pc++])) FAIL("out of memory");
+        PUSH(record);
+        VM_NEXT();
+    }
 
-        Lexer body_lex;
-        lexer_init(&body_lex, fn->data.lambda.body);
-        Parser body_parser;
-        body_parser.ctx = p->ctx;
-        body_parser.lex = &body_lex;
+    VM_CASE(OP_SET_FIELD) {
+        Goon_Value *value = POP();
+        const Goon_Symbol *name = names[code[pc++]];
+        record_set_cached(ctx, TOP(), name, value, &frame->proto->caches[code[pc++]]);
+        CHECK_MEMORY();
+        VM_NEXT();
+    }
 
-        if (!lexer_next(&body_lex)) {
-            p->ctx->env = old_env;
-            return NULL;
+    VM_CASE(OP_SET_PATH) {
+        Goon_Value *value = POP();
+        size_t path_len = code[pc++];
+        const Goon_Symbol *path[32];
+        for (size_t i = 0; i < path_len; i++) {
+            path[i] = names[code[pc++]];
+        }
+        Goon_Value *record = TOP();
+        for (size_t i = 0; i + 1 < path_len && value_type(record) == GOON_RECORD; i++) {
+            Goon_Value **slot = record_find(record, path[i]);
+            record = slot ? *slot : NULL;
+            if (value_type(record) == GOON_THUNK) {
+                FORCE(record);
+                *slot = record;
+            }
         }
+        goon_record_set_path(ctx, TOP(), path, path_len, value);
+        CHECK_MEMORY();
+        VM_NEXT();
+    }
 
-        Goon_Value *result = parse_expr(&body_parser);
+    VM_CASE(OP_SPREAD_RECORD) {
+        Goon_Value *value = TOP();
+        FORCE(value);
+        sp--;
+        if (value_type(value) == GOON_RECORD) record_spread(ctx, TOP(), value);
+        CHECK_MEMORY();
+        VM_NEXT();
+    }
 
-        p->ctx->env = old_env;
-        return result ? result : goon_nil(p->ctx);
+    VM_CASE(OP_SEAL) {
+        record_seal(ctx, TOP());
+        CHECK_MEMORY();
+        VM_NEXT();
     }
 
-    return goon_nil(p->ctx);
-}
+    VM_CASE(OP_LIST) {
+        Goon_Value *list = goon_list(ctx);
+        if (!list) FAIL("out of memory");
+        PUSH(list);
+        VM_NEXT();
+    }
 
-static Goon_Value *parse_primary(Parser *p) {
-    Token tok = p->lex->current;
+    VM_CASE(OP_APPEND) {
+        Goon_Value *value = POP();
+        goon_list_push(ctx, TOP(), value);
+        CHECK_MEMORY();
+        VM_NEXT();
+    }
 
-    switch (tok.type) {
-        case TOK_INT: {
-            Goon_Value *val = goon_int(p->ctx, tok.data.integer);
-            if (!lexer_next(p->lex)) return NULL;
-            return val;
+    VM_CASE(OP_JOIN_LIST) {
+        size_t count = code[pc++];
+        Goon_Value **lists = &stack[sp - count];
+        for (size_t i = sp - count; i < sp; i++) {
+            Goon_Value *part = stack[i];
+            FORCE(part);
+            stack[i] = part;
+            if (value_type(part) == GOON_SEQ && part->data.seq.fn) lists = NULL;
+        }
+        if (!lists) {
+            lists = ctx_alloc(ctx, count * sizeof(Goon_Value *));
+            CHECK_MEMORY();
+            if (!lists) FAIL("out of memory");
+            memcpy(lists, &stack[sp - count], count * sizeof(Goon_Value *));
         }
+        SAVE_STATE();
+        Goon_Value *list = list_join(ctx, lists, count);
+        LOAD_STATE();
+        CHECK_MEMORY();
+        if (!list) FAIL("out of memory");
+        sp -= count;
+        PUSH(list);
+        VM_NEXT();
+    }
 
-        case TOK_STRING: {
-            Goon_Value *val = interpolate_string(p->ctx, tok.data.string);
-            if (!lexer_next(p->lex)) return NULL;
-            return val;
+    VM_CASE(OP_CONCAT) {
+        size_t count = code[pc++];
+        char num_buf[24];
+        const char *text;
+        size_t total = 0;
+        for (size_t i = sp - count; i < sp; i++) {
+            Goon_Value *piece = stack[i];
+            FORCE(piece);
+            stack[i] = piece;
+            total += interp_text(piece, num_buf, &text);
+        }
+        Goon_Value *str = alloc_value_extra(ctx, GOON_STRING, total + 1);
+        if (!str) FAIL("out of memory");
+        ctx->stats.string_bytes += total + 1;
+        char *buf = (char *)(str + 1);
+        size_t len = 0;
+        for (size_t i = sp - count; i < sp; i++) {
+            size_t n = interp_text(stack[i], num_buf, &text);
+            memcpy(buf + len, text, n);
+            len += n;
         }
+        buf[len] = '\0';
+        str->data.string.ptr = buf;
+        str->data.string.len = len;
+        str->data.string.ctx = home_ctx(ctx);
+        str->data.string.terminated = true;
+        sp -= count;
+        PUSH(str);
+        VM_NEXT();
+    }
 
-        case TOK_TRUE: {
-            Goon_Value *val = goon_bool(p->ctx, true);
-            if (!lexer_next(p->lex)) return NULL;
-            return val;
+    VM_CASE(OP_CLOSURE) {
+        Proto *proto = frame->proto->protos[code[pc++]];
+        Goon_Value *fn = alloc_value_extra(ctx, GOON_LAMBDA, proto->capture_count * sizeof(Goon_Value *));
+        if (!fn) FAIL("out of memory");
+        fn->data.lambda.proto = proto;
+        fn->data.lambda.captures = (Goon_Value **)(fn + 1);
+        for (size_t i = 0; i < proto->capture_count; i++) {
+            Capture *cap = &proto->captures[i];
+            fn->data.lambda.captures[i] = cap->from_local ? slots[cap->index] : frame->captures[cap->index];
         }
+        PUSH(fn);
+        VM_NEXT();
+    }
 
-        case TOK_FALSE: {
-            Goon_Value *val = goon_bool(p->ctx, false);
-            if (!lexer_next(p->lex)) return NULL;
-            return val;
+    VM_CASE(OP_THUNK) {
+        Proto *proto = frame->proto->protos[code[pc++]];
+        Goon_Value *thunk = alloc_value_extra(ctx, GOON_THUNK, proto->capture_count * sizeof(Goon_Value *));
+        if (!thunk) FAIL("out of memory");
+        thunk->data.thunk.proto = proto;
+        thunk->data.thunk.captures = (Goon_Value **)(thunk + 1);
+        thunk->data.thunk.result = NULL;
+        thunk->data.thunk.ctx = ctx;
+        for (size_t i = 0; i < proto->capture_count; i++) {
+            Capture *cap = &proto->captures[i];
+            thunk->data.thunk.captures[i] = cap->from_local ? slots[cap->index] : frame->captures[cap->index];
         }
+        PUSH(thunk);
+        VM_NEXT();
+    }
 
-        case TOK_IDENT: {
-            char *name = strdup(tok.data.string);
-            if (!lexer_next(p->lex)) { free(name); return NULL; }
+    VM_CASE(OP_CALL) {
+        size_t argc = code[pc++];
+        Goon_Value *fn = stack[sp - argc - 1];
+        FORCE(fn);
+
+        Goon_Type fn_type = value_type(fn);
+        if (fn_type == GOON_LAMBDA) {
+            Proto *proto = fn->data.lambda.proto;
+            if (argc != proto->param_count) FAIL("wrong number of arguments");
+            stack[sp - argc - 1] = fn;
+            uint64_t hash = 0;
+            if (ctx->memo) {
+                hash = memo_hash(fn, &stack[sp - argc], argc);
+                Goon_Value *hit = memo_find(ctx->memo, fn, &stack[sp - argc], argc, hash);
+                if (hit) {
+                    sp -= argc + 1;
+                    PUSH(hit);
+                    VM_NEXT();
+                }
+            }
+            SAVE_STATE();
+            if (!vm_push_frame(ctx, proto, fn->data.lambda.captures, sp - argc)) goto error;
+            if (ctx->memo && !ctx->scratch_on) {
+                vm->frames[vm->frame_count - 1].memo_fn = fn;
+                vm->frames[vm->frame_count - 1].memo_hash = hash;
+            }
+            LOAD_STATE();
+            VM_NEXT();
+        }
 
-            if (p->lex->current.type == TOK_LPAREN) {
-                Goon_Value *result = parse_call(p, name);
-                free(name);
-                return result;
+        Goon_Value *result;
+        if (fn_type == GOON_BUILTIN) {
+            Goon_Value *args[16];
+            for (size_t i = 0; i < argc; i++) {
+                args[i] = stack[sp - argc + i];
+                FORCE(args[i]);
             }
+            SAVE_STATE();
+            result = fn->data.builtin(ctx, args, argc);
+            if (ctx->error.message) goto error;
+            LOAD_STATE();
+            CHECK_MEMORY();
+            if (!result) result = goon_nil(ctx);
+        } else {
+            result = goon_nil(ctx);
+        }
+        sp -= argc + 1;
+        if (!result) FAIL("out of memory");
+        PUSH(result);
+        VM_NEXT();
+    }
 
-            if (p->lex->current.type == TOK_DOT) {
-                Goon_Value *val = lookup(p->ctx, name);
-                free(name);
+    VM_CASE(OP_JUMP) {
+        pc = code[pc];
+        VM_NEXT();
+    }
 
-                while (p->lex->current.type == TOK_DOT) {
-                    if (!lexer_next(p->lex)) return NULL;
-                    if (p->lex->current.type != TOK_IDENT) {
-                        lexer_set_error(p->lex,"expected field name after .");
-                        return NULL;
-                    }
-                    char *field = p->lex->current.data.string;
-                    val = goon_record_get(val, field);
-                    if (!lexer_next(p->lex)) return NULL;
-                }
-                return val ? val : goon_nil(p->ctx);
-            }
+    VM_CASE(OP_JUMP_IF_FALSE) {
+        Goon_Value *cond = TOP();
+        FORCE(cond);
+        sp--;
+        if (goon_to_bool(cond)) {
+            pc++;
+        } else {
+            pc = code[pc];
+        }
+        VM_NEXT();
+    }
+
+    VM_CASE(OP_IMPORT) {
+        Goon_Value *path = consts[code[pc++]];
+        SAVE_STATE();
+        bool paused = scratch_pause(ctx, NULL);
+        Goon_Value *result = run_import(ctx, frame, path->data.string.ptr);
+        scratch_resume(ctx, paused);
+        if (!result) goto error;
+        LOAD_STATE();
+        PUSH(result);
+        VM_NEXT();
+    }
 
-            Goon_Value *val = lookup(p->ctx, name);
-            free(name);
-            return val ? val : goon_nil(p->ctx);
+    VM_CASE(OP_RETURN) {
+        Goon_Value *result = POP();
+        if (frame->memo_fn) {
+            memo_store(ctx->memo, frame->memo_fn, slots, frame->proto->param_count, frame->memo_hash, result);
+        }
+        vm->frame_count--;
+        vm->sp = frame->base - 1;
+        if (vm->frame_count == entry) {
+            return result;
         }
+        LOAD_STATE();
+        PUSH(result);
+        VM_NEXT();
+    }
 
-        case TOK_LBRACE:
-            return parse_record(p);
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
 
-        case TOK_LBRACKET:
-            return parse_list(p);
+error:
+    while (vm->frame_count > entry) {
+        frame = &vm->frames[--vm->frame_count];
+        vm->sp = frame->base - 1;
+    }
+    if (!ctx->error.message) set_error(ctx, NULL, 0, "evaluation failed");
+    return NULL;
 
-        case TOK_IMPORT:
-            return parse_import(p);
+#undef PUSH
+#undef POP
+#undef TOP
+#undef SAVE_STATE
+#undef LOAD_STATE
+#undef FAIL
+#undef CHECK_MEMORY
+#undef FORCE
+#undef VM_CASE
+#undef VM_NEXT
+}
 
-        case TOK_LPAREN: {
-            Lexer_State saved;
-            lexer_save(p->lex, &saved);
+static void clear_error(Goon_Ctx *ctx);
+
+static void sources_free(Goon_Source *s) {
+    while (s) {
+        Goon_Source *next = s->next;
+        free(s->name);
+        if (!s->borrowed) text_free(s->text, s->len, s->mapped);
+        free(s->tokens);
+        free(s->lines);
+        arena_free(&s->arena);
+        Proto *proto = s->protos;
+        while (proto) {
+            Proto *next_proto = proto->next;
+            proto_free(proto);
+            proto = next_proto;
+        }
+        free(s);
+        s = next;
+    }
+}
 
-            if (!lexer_next(p->lex)) { lexer_state_free(&saved); return NULL; }
+static void stats_merge(Goon_Ctx *ctx, Goon_Ctx *worker) {
+    Goon_Stats *to = &ctx->stats;
+    Goon_Stats *from = &worker->stats;
+    to->bytes_allocated += from->bytes_allocated;
+    to->bytes_reserved += from->bytes_reserved;
+    if (to->bytes_reserved > to->peak_bytes) to->peak_bytes = to->bytes_reserved;
+    for (size_t i = 0; i < GOON_TYPE_COUNT; i++) to->values[i] += from->values[i];
+    to->thunks += from->thunks;
+    to->fields += from->fields;
+    to->shapes += from->shapes;
+    to->bindings += from->bindings;
+    to->string_bytes += from->string_bytes;
+    to->module_hits += from->module_hits;
+    to->module_misses += from->module_misses;
+    memset(from, 0, sizeof(*from));
+}
 
-            char *params[16];
-            size_t param_count = 0;
-            bool is_lambda = true;
-
-            if (p->lex->current.type == TOK_RPAREN) {
-                if (!lexer_next(p->lex)) { lexer_state_free(&saved); return NULL; }
-                is_lambda = (p->lex->current.type == TOK_ARROW);
-            } else if (p->lex->current.type == TOK_IDENT) {
-                while (is_lambda && param_count < 16) {
-                    if (p->lex->current.type != TOK_IDENT) {
-                        is_lambda = false;
-                        break;
-                    }
-                    params[param_count++] = strdup(p->lex->current.data.string);
-                    if (!lexer_next(p->lex)) {
-                        for (size_t i = 0; i < param_count; i++) free(params[i]);
-                        lexer_state_free(&saved);
-                        return NULL;
-                    }
-                    if (p->lex->current.type == TOK_COMMA) {
-                        if (!lexer_next(p->lex)) {
-                            for (size_t i = 0; i < param_count; i++) free(params[i]);
-                            lexer_state_free(&saved);
-                            return NULL;
-                        }
-                    } else if (p->lex->current.type == TOK_RPAREN) {
-                        if (!lexer_next(p->lex)) {
-                            for (size_t i = 0; i < param_count; i++) free(params[i]);
-                            lexer_state_free(&saved);
-                            return NULL;
-                        }
-                        is_lambda = (p->lex->current.type == TOK_ARROW);
-                        break;
-                    } else {
-                        is_lambda = false;
-                        break;
-                    }
-                }
-            } else {
-                is_lambda = false;
-            }
+static void worker_destroy(Goon_Ctx *ctx, Goon_Ctx *worker) {
+    if (!worker) return;
+    stats_merge(ctx, worker);
+
+    Arena *arena = worker->arena;
+    if (arena && arena->head) {
+        Arena_Chunk *last = arena->head;
+        while (last->next) last = last->next;
+        Arena *into = ctx->arena;
+        if (into->head) {
+            last->next = into->head->next;
+            into->head->next = arena->head;
+        } else {
+            into->head = arena->head;
+        }
+        into->reserved += arena->reserved;
+    }
 
-            if (is_lambda) {
-                lexer_state_free(&saved);
-                if (!lexer_next(p->lex)) {
-                    for (size_t i = 0; i < param_count; i++) free(params[i]);
-                    return NULL;
-                }
-                size_t body_start = p->lex->token_start;
-                Goon_Value *body_val = parse_expr(p);
-                if (!body_val) {
-                    for (size_t i = 0; i < param_count; i++) free(params[i]);
-                    return NULL;
-                }
-                size_t body_end = p->lex->token_start;
-                char *body_src = strdup_range(p->lex->src + body_start, body_end - body_start);
+    if (worker->sources) {
+        Goon_Source *last = worker->sources;
+        for (;; last = last->next) {
+            last->arena.owner = ctx;
+            if (!last->next) break;
+        }
+        last->next = ctx->sources;
+        ctx->sources = worker->sources;
+    }
 
-                Goon_Value *lambda = goon_lambda(p->ctx, params, param_count, body_src, p->ctx->env);
-                free(body_src);
-                for (size_t i = 0; i < param_count; i++) free(params[i]);
-                return lambda;
-            } else {
-                for (size_t i = 0; i < param_count; i++) free(params[i]);
-                lexer_restore(p->lex, &saved);
+    clear_error(worker);
+    vm_destroy(worker->vm);
+    free(arena);
+    free(worker);
+}
 
-                if (!lexer_next(p->lex)) return NULL;
-                Goon_Value *val = parse_expr(p);
-                if (p->lex->current.type != TOK_RPAREN) {
-                    lexer_set_error(p->lex, "expected )");
-                    return NULL;
+static Goon_Ctx *worker_create(Goon_Ctx *ctx, Goon_Pool *pool) {
+    Goon_Ctx *worker = calloc(1, sizeof(Goon_Ctx));
+    if (!worker) return NULL;
+    worker->symbols = ctx->symbols;
+    worker->parent = ctx;
+    worker->pool = pool;
+    worker->arena = calloc(1, sizeof(Arena));
+    if (worker->arena) {
+        worker->arena->owner = worker;
+        worker->empty_shape = shape_root(worker);
+    }
+    worker->vm = vm_create();
+    if (!worker->empty_shape || !worker->vm) {
+        worker_destroy(ctx, worker);
+        return NULL;
+    }
+    return worker;
+}
+
+static void map_run(Goon_Pool *pool, Map_Job *job, Goon_Ctx *worker) {
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        size_t start = job->next;
+        bool done = start >= job->len || job->failed_worker;
+        if (!done) job->next += MAP_CHUNK;
+        pthread_mutex_unlock(&pool->lock);
+        if (done) return;
+
+        size_t end = job->len - start > MAP_CHUNK ? start + MAP_CHUNK : job->len;
+        for (size_t i = start; i < end; i++) {
+            Goon_Value *args[1] = { job->items[i] };
+            Goon_Value *mapped = call_value(worker, job->fn, args, 1);
+            if (!mapped || worker->error.message) {
+                pthread_mutex_lock(&pool->lock);
+                if (!job->failed_worker || i < job->failed) {
+                    job->failed = i;
+                    job->failed_worker = worker;
                 }
-                if (!lexer_next(p->lex)) return NULL;
-                return val;
+                pthread_mutex_unlock(&pool->lock);
+                return;
             }
+            job->out[i] = mapped;
         }
-
-        default:
-            return NULL;
     }
 }
 
-static Goon_Value *parse_expr(Parser *p) {
-    if (p->lex->current.type == TOK_LET) {
-        if (!lexer_next(p->lex)) return NULL;
+static void *pool_thread(void *arg) {
+    Goon_Ctx *worker = arg;
+    Goon_Pool *pool = worker->pool;
+    size_t seen = 0;
 
-        if (p->lex->current.type != TOK_IDENT) {
-            lexer_set_error(p->lex,"expected identifier after let");
-            return NULL;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
         }
+        if (pool->stop) break;
+        seen = pool->generation;
+        Map_Job *job = pool->job;
+        pthread_mutex_unlock(&pool->lock);
 
-        char *name = strdup(p->lex->current.data.string);
-        if (!lexer_next(p->lex)) { free(name); return NULL; }
+        map_run(pool, job, worker);
 
-        if (p->lex->current.type == TOK_COLON) {
-            if (!lexer_next(p->lex)) { free(name); return NULL; }
-            if (!lexer_next(p->lex)) { free(name); return NULL; }
-        }
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
 
-        if (p->lex->current.type != TOK_EQUALS) {
-            lexer_set_error(p->lex,"expected = in let binding");
-            free(name);
-            return NULL;
-        }
+static void pool_destroy(Goon_Ctx *ctx, Goon_Pool *pool) {
+    if (!pool) return;
 
-        if (!lexer_next(p->lex)) { free(name); return NULL; }
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 1; i <= pool->started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
 
-        Goon_Value *value = parse_expr(p);
-        if (!value) { free(name); return NULL; }
+    for (size_t i = 0; i < pool->count; i++) {
+        worker_destroy(ctx, pool->workers[i]);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->source_lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
 
-        define(p->ctx, name, value);
-        free(name);
+static Goon_Pool *pool_create(Goon_Ctx *ctx, size_t count) {
+    Goon_Pool *pool = calloc(1, sizeof(Goon_Pool));
+    if (!pool) return NULL;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&pool->source_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    pool->workers = calloc(count, sizeof(Goon_Ctx *));
+    pool->threads = calloc(count, sizeof(pthread_t));
+    if (!pool->workers || !pool->threads) {
+        pool_destroy(ctx, pool);
+        return NULL;
+    }
 
-        if (p->lex->current.type != TOK_SEMICOLON) {
-            lexer_set_error(p->lex, "expected ; after let binding");
+    for (size_t i = 0; i < count; i++) {
+        pool->workers[i] = worker_create(ctx, pool);
+        if (!pool->workers[i]) {
+            pool_destroy(ctx, pool);
             return NULL;
         }
-        if (!lexer_next(p->lex)) return NULL;
-
-        return value;
+        pool->count++;
+    }
+    for (size_t i = 1; i < count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, pool_thread, pool->workers[i]) != 0) break;
+        pool->started++;
     }
+    return pool;
+}
 
-    if (p->lex->current.type == TOK_IF) {
-        if (!lexer_next(p->lex)) return NULL;
+static bool pool_map(Goon_Ctx *ctx, Goon_Value *fn, Goon_Value **items, Goon_Value **out, size_t len) {
+    Goon_Pool *pool = ctx->pool;
+    Map_Job job = { fn, items, out, len, 0, 0, NULL };
 
-        Goon_Value *cond = parse_expr(p);
-        if (!cond) return NULL;
+    size_t share = 0;
+    if (ctx->memory_limit) {
+        size_t used = ctx->stats.bytes_reserved;
+        share = ctx->memory_limit > used ? (ctx->memory_limit - used) / (pool->started + 1) : 0;
+        if (share == 0) share = 1;
+    }
+    for (size_t i = 0; i <= pool->started; i++) {
+        Goon_Ctx *worker = pool->workers[i];
+        worker->globals = ctx->globals;
+        worker->base_path = ctx->base_path;
+        worker->userdata = ctx->userdata;
+        worker->memory_limit = share;
+    }
 
-        if (p->lex->current.type != TOK_THEN) {
-            lexer_set_error(p->lex,"expected 'then' after if condition");
-            return NULL;
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->busy = pool->started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    map_run(pool, &job, pool->workers[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) pthread_cond_wait(&pool->idle, &pool->lock);
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i <= pool->started; i++) {
+        Goon_Ctx *worker = pool->workers[i];
+        worker->base_path = NULL;
+        stats_merge(ctx, worker);
+        if (worker == job.failed_worker && !ctx->error.message) {
+            ctx->error = worker->error;
+            memset(&worker->error, 0, sizeof(worker->error));
+            if (worker->memory_exceeded) ctx->memory_exceeded = true;
         }
+        clear_error(worker);
+    }
+    return !job.failed_worker;
+}
+
+static pthread_mutex_t *shared_lock(Goon_Ctx *ctx) {
+    Goon_Pool *pool = home_ctx(ctx)->pool;
+    return pool && (ctx->parent || pool->job) ? &pool->source_lock : NULL;
+}
 
-        if (!lexer_next(p->lex)) return NULL;
+static bool map_parallel(Goon_Ctx *ctx, size_t len) {
+    return ctx->pool && !ctx->parent && !ctx->lazy && !ctx->scratch_on && len > MAP_CHUNK;
+}
 
-        Goon_Value *then_val = parse_expr(p);
-        if (!then_val) return NULL;
+static bool is_callable(Goon_Value *fn) {
+    Goon_Type type = value_type(fn);
+    return type == GOON_LAMBDA || type == GOON_BUILTIN;
+}
 
-        if (p->lex->current.type != TOK_ELSE) {
-            lexer_set_error(p->lex,"expected 'else' after then branch");
-            return NULL;
+static bool list_items(Goon_Ctx *ctx, Goon_Value *list, Goon_Value ***items, size_t *len) {
+    *len = goon_list_len(list);
+    if (value_type(list) == GOON_SEQ && list->data.seq.fn && !shared_lock(ctx) && !seq_fill(ctx, list)) return false;
+    if (seq_is_view(list) && list->data.seq.part_count == 1 && list->data.seq.parts[0].start == 0 &&
+        value_type(list->data.seq.parts[0].list) == GOON_LIST) {
+        list = list->data.seq.parts[0].list;
+    } else if (seq_is_view(list)) {
+        list = list_flatten(ctx, list);
+        if (!list) return false;
+    }
+    if (value_type(list) == GOON_LIST) {
+        *items = list->data.list.items;
+        return true;
+    }
+    *items = ctx_alloc(ctx, *len * sizeof(Goon_Value *));
+    if (!*items) return false;
+    for (size_t i = 0; i < *len; i++) {
+        (*items)[i] = seq_get(ctx, list, i, false);
+        if (!(*items)[i]) return false;
+    }
+    return true;
+}
+
+static bool map_items(Goon_Ctx *ctx, Goon_Value *fn, Goon_Value **items, Goon_Value **out, size_t len) {
+    if (map_parallel(ctx, len)) {
+        return pool_map(ctx, fn, items, out, len);
+    }
+    for (size_t i = 0; i < len; i++) {
+        Goon_Value *fn_args[1] = { items[i] };
+        out[i] = call_value(ctx, fn, fn_args, 1);
+        if (!out[i] || ctx->error.message) return false;
+    }
+    return true;
+}
+
+static Goon_Value *list_pair(Goon_Ctx *ctx, Goon_Value *first, Goon_Value *second) {
+    Goon_Value *pair = alloc_value_extra(ctx, GOON_LIST, 2 * sizeof(Goon_Value *));
+    if (!pair) return NULL;
+    pair->data.list.items = (Goon_Value **)(pair + 1);
+    pair->data.list.items[0] = first;
+    pair->data.list.items[1] = second;
+    pair->data.list.len = 2;
+    pair->data.list.cap = 2;
+    pair->data.list.ctx = home_ctx(ctx);
+    pair->data.list.packed = NULL;
+    pair->data.list.kind = LIST_UNKNOWN;
+    return pair;
+}
+
+static Goon_Value *builtin_map(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc != 2) return goon_nil(ctx);
+    Goon_Value *list = args[0];
+    Goon_Value *fn = args[1];
+
+    if (!goon_is_list(list) || !is_callable(fn)) return goon_nil(ctx);
+    if (value_type(list) == GOON_SEQ && !seq_is_view(list)) {
+        if (ctx->lazy) return seq_map(ctx, list, fn);
+        if (scratch_free(ctx) && !map_parallel(ctx, goon_list_len(list))) {
+            Goon_Value *seq = seq_map(ctx, list, fn);
+            return seq && seq_check(ctx, seq) ? seq : NULL;
         }
+    }
 
-        if (!lexer_next(p->lex)) return NULL;
+    Goon_Value **items;
+    size_t len;
+    if (!list_items(ctx, list, &items, &len)) return NULL;
+    Goon_Value *result = list_sized(ctx, len);
+    if (!result || !map_items(ctx, fn, items, result->data.list.items, len)) return NULL;
+    result->data.list.len = len;
+    return result;
+}
 
-        Goon_Value *else_val = parse_expr(p);
-        if (!else_val) return NULL;
+static Goon_Value *builtin_filter(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc != 2 || !goon_is_list(args[0]) || !is_callable(args[1])) return goon_nil(ctx);
 
-        return goon_to_bool(cond) ? then_val : else_val;
+    Goon_Value **items;
+    size_t len;
+    if (!list_items(ctx, args[0], &items, &len)) return NULL;
+    Goon_Value *result = list_sized(ctx, len);
+    if (!result) return NULL;
+
+    Goon_Value **out = result->data.list.items;
+    if (!map_items(ctx, args[1], items, out, len)) return NULL;
+    size_t kept = 0;
+    for (size_t i = 0; i < len; i++) {
+        Goon_Value *keep = force(out[i]);
+        if (!keep) return NULL;
+        if (goon_to_bool(keep)) out[kept++] = items[i];
     }
+    result->data.list.len = kept;
+    return result;
+}
 
-    Goon_Value *val = parse_primary(p);
-    if (!val) return NULL;
+static Goon_Value *builtin_fold(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc != 3 || !goon_is_list(args[0]) || !is_callable(args[2])) return goon_nil(ctx);
 
-    if (p->lex->current.type == TOK_QUESTION) {
-        if (!lexer_next(p->lex)) return NULL;
+    Goon_Value **items;
+    size_t len;
+    if (!list_items(ctx, args[0], &items, &len)) return NULL;
+    Goon_Value *acc = args[1];
+    for (size_t i = 0; i < len; i++) {
+        Goon_Value *fn_args[2] = { acc, items[i] };
+        acc = call_value(ctx, args[2], fn_args, 2);
+        if (!acc || ctx->error.message) return NULL;
+    }
+    return acc;
+}
 
-        Goon_Value *then_val = parse_expr(p);
-        if (!then_val) return NULL;
+static Goon_Value *builtin_flat_map(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc != 2 || !goon_is_list(args[0]) || !is_callable(args[1])) return goon_nil(ctx);
 
-        if (p->lex->current.type != TOK_COLON) {
-            lexer_set_error(p->lex,"expected : in ternary");
+    Goon_Value **items;
+    size_t len;
+    if (!list_items(ctx, args[0], &items, &len)) return NULL;
+    Goon_Value **mapped = ctx_alloc(ctx, len * sizeof(Goon_Value *));
+    if (!mapped || !map_items(ctx, args[1], items, mapped, len)) return NULL;
+
+    size_t total = 0;
+    for (size_t i = 0; i < len; i++) {
+        mapped[i] = force(mapped[i]);
+        if (!mapped[i]) return NULL;
+        total += goon_is_list(mapped[i]) ? goon_list_len(mapped[i]) : 1;
+    }
+    Goon_Value *result = list_sized(ctx, total);
+    if (!result) return NULL;
+    for (size_t i = 0; i < len; i++) {
+        if (!goon_is_list(mapped[i])) {
+            result->data.list.items[result->data.list.len++] = mapped[i];
+        } else if (!list_extend(ctx, result, mapped[i])) {
             return NULL;
         }
+    }
+    return result;
+}
+
+static Goon_Value *builtin_concat(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    for (size_t i = 0; i < argc; i++) {
+        if (!goon_is_list(args[i])) return goon_nil(ctx);
+    }
+    return list_join(ctx, args, argc);
+}
+
+static Goon_Value *builtin_slice(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc < 2 || argc > 3 || !goon_is_list(args[0])) return goon_nil(ctx);
+    size_t len = goon_list_len(args[0]);
+    int64_t bounds[2] = { 0, (int64_t)len };
+    for (size_t i = 1; i < argc; i++) {
+        if (value_type(args[i]) != GOON_INT) return goon_nil(ctx);
+        int64_t v = int_value(args[i]);
+        if (v < 0) v += (int64_t)len;
+        if (v < 0) v = 0;
+        if (v > (int64_t)len) v = (int64_t)len;
+        bounds[i - 1] = v;
+    }
+    if (bounds[1] < bounds[0]) bounds[1] = bounds[0];
+    return list_slice(ctx, args[0], (size_t)bounds[0], (size_t)bounds[1]);
+}
 
-        if (!lexer_next(p->lex)) return NULL;
+static Goon_Value *builtin_zip(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc != 2 || !goon_is_list(args[0]) || !goon_is_list(args[1])) return goon_nil(ctx);
+
+    Goon_Value **left, **right;
+    size_t left_len, right_len;
+    if (!list_items(ctx, args[0], &left, &left_len) || !list_items(ctx, args[1], &right, &right_len)) return NULL;
+    size_t len = left_len < right_len ? left_len : right_len;
+    Goon_Value *result = list_sized(ctx, len);
+    if (!result) return NULL;
+    for (size_t i = 0; i < len; i++) {
+        Goon_Value *pair = list_pair(ctx, left[i], right[i]);
+        if (!pair) return NULL;
+        result->data.list.items[i] = pair;
+    }
+    result->data.list.len = len;
+    return result;
+}
 
-        Goon_Value *else_val = parse_expr(p);
-        if (!else_val) return NULL;
+static Goon_Value *builtin_enumerate(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc != 1 || !goon_is_list(args[0])) return goon_nil(ctx);
 
-        return goon_to_bool(val) ? then_val : else_val;
+    Goon_Value **items;
+    size_t len;
+    if (!list_items(ctx, args[0], &items, &len)) return NULL;
+    Goon_Value *result = list_sized(ctx, len);
+    if (!result) return NULL;
+    for (size_t i = 0; i < len; i++) {
+        Goon_Value *pair = list_pair(ctx, goon_int(ctx, (int64_t)i), items[i]);
+        if (!pair) return NULL;
+        result->data.list.items[i] = pair;
     }
+    result->data.list.len = len;
+    return result;
+}
 
-    return val;
+static Goon_Value *builtin_range(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    if (argc < 2 || argc > 3) return goon_nil(ctx);
+    for (size_t i = 0; i < argc; i++) {
+        if (value_type(args[i]) != GOON_INT) return goon_nil(ctx);
+    }
+    int64_t step = argc == 3 ? int_value(args[2]) : 1;
+    if (step == 0) return goon_nil(ctx);
+    return seq_range(ctx, int_value(args[0]), int_value(args[1]), step);
 }
 
 static void clear_error(Goon_Ctx *ctx) {
@@ -1265,21 +4936,230 @@ static void clear_error(Goon_Ctx *ctx) {
     if (ctx->error.source_line) { free(ctx->error.source_line); ctx->error.source_line = NULL; }
     ctx->error.line = 0;
     ctx->error.col = 0;
+    ctx->memory_exceeded = false;
+}
+
+static bool source_build_lines(Goon_Source *src) {
+    size_t count = 1;
+    const char *p = src->text;
+    const char *end = src->text + src->len;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        count++;
+        p++;
+    }
+
+    src->lines = malloc(count * sizeof(size_t));
+    if (!src->lines) return false;
+
+    src->lines[0] = 0;
+    src->line_count = 1;
+    p = src->text;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        p++;
+        src->lines[src->line_count++] = p - src->text;
+    }
+    return true;
+}
+
+static void source_position(Goon_Source *src, size_t pos, size_t *line, size_t *col) {
+    if (!src->lines && (!src->text || !source_build_lines(src))) {
+        *line = 0;
+        *col = 0;
+        return;
+    }
+
+    size_t lo = 0;
+    size_t hi = src->line_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (src->lines[mid] <= pos) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    *line = lo + 1;
+    *col = pos - src->lines[lo] + 1;
 }
 
-static char *get_source_line(const char *src, size_t line_start) {
-    const char *start = src + line_start;
-    const char *end = start;
-    while (*end && *end != '\n') end++;
-    return strdup_range(start, end - start);
+static void set_error(Goon_Ctx *ctx, Goon_Source *src, size_t pos, const char *msg) {
+    if (ctx->error.message) return;
+    if (ctx->memory_exceeded) msg = "memory limit exceeded";
+    ctx->error.message = strdup(msg);
+    if (!src) return;
+    if (src->name) ctx->error.file = strdup(src->name);
+
+    size_t line, col;
+    Goon_Pool *pool = ctx->parent ? ctx->pool : NULL;
+    if (pool) pthread_mutex_lock(&pool->source_lock);
+    source_position(src, pos, &line, &col);
+    if (pool) pthread_mutex_unlock(&pool->source_lock);
+    if (line == 0) return;
+
+    size_t line_start = src->lines[line - 1];
+    size_t line_end = line < src->line_count ? src->lines[line] - 1 : src->len;
+
+    ctx->error.line = line;
+    ctx->error.col = col;
+    if (src->text) ctx->error.source_line = strdup_range(src->text + line_start, line_end - line_start);
 }
 
-Goon_Ctx *goon_create(void) {
+static void sources_detach(Goon_Ctx *ctx) {
+    for (Goon_Source *s = ctx->sources; s; s = s->next) {
+        if (!s->borrowed || !s->text) continue;
+        if (!s->lines) source_build_lines(s);
+        s->text = NULL;
+    }
+}
+
+static Goon_Source *load_source(Goon_Ctx *ctx, const char *name, char *text, size_t len, bool mapped, bool borrowed, Lexer *lexed) {
+    if (len > UINT32_MAX) {
+        if (!borrowed) text_free(text, len, mapped);
+        set_error(ctx, NULL, 0, "source too large");
+        return NULL;
+    }
+    Goon_Source *src = malloc(sizeof(Goon_Source));
+    if (!src) {
+        if (!borrowed) text_free(text, len, mapped);
+        if (lexed) free(lexed->tokens);
+        set_error(ctx, NULL, 0, "out of memory");
+        return NULL;
+    }
+    src->name = name ? strdup(name) : NULL;
+    src->text = text;
+    src->len = len;
+    src->mapped = mapped;
+    src->borrowed = borrowed;
+    src->lines = NULL;
+    src->line_count = 0;
+    src->arena.head = NULL;
+    src->arena.reserved = 0;
+    src->arena.owner = ctx;
+    src->exprs = NULL;
+    src->expr_count = 0;
+    src->main = NULL;
+    src->protos = NULL;
+    src->module = NULL;
+    src->next = ctx->sources;
+    ctx->sources = src;
+
+    Lexer lex;
+    bool ok;
+    if (lexed) {
+        lex = *lexed;
+        ok = !lex.error && lexer_bind(&lex, ctx->symbols);
+    } else {
+        lexer_init(&lex, text, len, ctx->symbols);
+        ok = lexer_run(&lex);
+    }
+    src->tokens = lex.tokens;
+    src->token_count = lex.count;
+    if (!ok) {
+        set_error(ctx, src, lex.error_pos, lex.error);
+        return NULL;
+    }
+
+    Parser parser;
+    parser_init(&parser, ctx, src);
+    if (!parse_program(&parser)) return NULL;
+
+    src->main = compile_program(ctx, src);
+    arena_free(&src->arena);
+    src->exprs = NULL;
+    src->expr_count = 0;
+    return src->main ? src : NULL;
+}
+
+static char *read_stream(int fd, size_t *out_len) {
+    size_t cap = 4096;
+    size_t len = 0;
+    char *text = malloc(cap);
+    while (text) {
+        if (len + 1 >= cap) {
+            char *grown = realloc(text, cap * 2);
+            if (!grown) break;
+            text = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, text + len, cap - len - 1);
+        if (n == 0) {
+            text[len] = '\0';
+            *out_len = len;
+            return text;
+        }
+        if (n < 0) break;
+        len += (size_t)n;
+    }
+    free(text);
+    return NULL;
+}
+
+static char *read_file(const char *path, size_t *out_len, bool *mapped) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    char *text = NULL;
+    *mapped = false;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+            text = map;
+            *out_len = (size_t)st.st_size;
+            *mapped = true;
+        }
+    }
+    if (!text) text = read_stream(fd, out_len);
+    close(fd);
+    return text;
+}
+
+static void text_free(char *text, size_t len, bool mapped) {
+    if (mapped) {
+        munmap(text, len);
+    } else {
+        free(text);
+    }
+}
+
+static Goon_Ctx *ctx_create(Goon_Symtab *symbols) {
     Goon_Ctx *ctx = malloc(sizeof(Goon_Ctx));
     if (!ctx) return NULL;
-    ctx->env = NULL;
-    ctx->values = NULL;
-    ctx->fields = NULL;
+    if (symbols) {
+        symbols->refs++;
+    } else {
+        symbols = symtab_create();
+        if (!symbols) {
+            free(ctx);
+            return NULL;
+        }
+    }
+    ctx->symbols = symbols;
+    ctx->globals = NULL;
+    ctx->result = NULL;
+    ctx->sources = NULL;
+    ctx->modules = NULL;
+    ctx->imports = NULL;
+    ctx->prefetch = NULL;
+    ctx->arena = calloc(1, sizeof(Arena));
+    if (ctx->arena) ctx->arena->owner = ctx;
+    ctx->scratch = NULL;
+    ctx->scratch_on = false;
+    ctx->scratch_busy = false;
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    ctx->memory_limit = 0;
+    ctx->memory_exceeded = false;
+    ctx->empty_shape = ctx->arena ? shape_root(ctx) : NULL;
+    ctx->vm = vm_create();
+    if (!ctx->empty_shape || !ctx->vm) {
+        if (ctx->arena) arena_free(ctx->arena);
+        free(ctx->arena);
+        vm_destroy(ctx->vm);
+        symtab_release(symbols);
+        free(ctx);
+        return NULL;
+    }
     ctx->error.message = NULL;
     ctx->error.file = NULL;
     ctx->error.line = 0;
@@ -1287,54 +5167,48 @@ Goon_Ctx *goon_create(void) {
     ctx->error.source_line = NULL;
     ctx->base_path = NULL;
     ctx->userdata = NULL;
+    ctx->lazy = false;
+    ctx->memo = NULL;
+    ctx->pool = NULL;
+    ctx->parent = NULL;
 
     goon_register(ctx, "map", builtin_map);
+    goon_register(ctx, "filter", builtin_filter);
+    goon_register(ctx, "fold", builtin_fold);
+    goon_register(ctx, "flat_map", builtin_flat_map);
+    goon_register(ctx, "concat", builtin_concat);
+    goon_register(ctx, "slice", builtin_slice);
+    goon_register(ctx, "zip", builtin_zip);
+    goon_register(ctx, "enumerate", builtin_enumerate);
+    goon_register(ctx, "range", builtin_range);
 
     return ctx;
 }
 
+Goon_Ctx *goon_create(void) {
+    return ctx_create(NULL);
+}
+
+Goon_Ctx *goon_create_shared(Goon_Ctx *other) {
+    return ctx_create(other ? other->symbols : NULL);
+}
+
 void goon_destroy(Goon_Ctx *ctx) {
     if (!ctx) return;
 
-    Goon_Binding *b = ctx->env;
-    while (b) {
-        Goon_Binding *next = b->next;
-        free(b->name);
-        free(b);
-        b = next;
-    }
-
-    Goon_Value *v = ctx->values;
-    while (v) {
-        Goon_Value *next = v->next_alloc;
-        if (v->type == GOON_STRING && v->data.string) {
-            free(v->data.string);
-        } else if (v->type == GOON_LIST && v->data.list.items) {
-            free(v->data.list.items);
-        } else if (v->type == GOON_LAMBDA) {
-            if (v->data.lambda.params) {
-                for (size_t i = 0; i < v->data.lambda.param_count; i++) {
-                    free(v->data.lambda.params[i]);
-                }
-                free(v->data.lambda.params);
-            }
-            if (v->data.lambda.body) {
-                free(v->data.lambda.body);
-            }
-        }
-        free(v);
-        v = next;
-    }
-
-    Goon_Record_Field *f = ctx->fields;
-    while (f) {
-        Goon_Record_Field *next = f->next;
-        if (f->key) free(f->key);
-        free(f);
-        f = next;
-    }
+    prefetch_free(ctx->prefetch);
+    pool_destroy(ctx, ctx->pool);
+    arena_free(ctx->arena);
+    free(ctx->arena);
+    if (ctx->scratch) arena_free(ctx->scratch);
+    free(ctx->scratch);
+    sources_free(ctx->sources);
+    modules_free(ctx->modules);
 
     clear_error(ctx);
+    vm_destroy(ctx->vm);
+    memo_free(ctx->memo);
+    symtab_release(ctx->symbols);
     if (ctx->base_path) free(ctx->base_path);
     free(ctx);
 }
@@ -1347,97 +5221,211 @@ void *goon_get_userdata(Goon_Ctx *ctx) {
     return ctx->userdata;
 }
 
+void goon_set_lazy(Goon_Ctx *ctx, bool lazy) {
+    ctx->lazy = lazy;
+}
+
+void goon_set_memo(Goon_Ctx *ctx, size_t max_entries) {
+    memo_free(ctx->memo);
+    ctx->memo = NULL;
+    if (max_entries == 0) return;
+
+    size_t cap = 1;
+    while (cap < max_entries) cap <<= 1;
+    Goon_Memo *memo = calloc(1, sizeof(Goon_Memo));
+    if (!memo) return;
+    memo->entries = calloc(cap, sizeof(Memo_Entry));
+    if (!memo->entries) {
+        free(memo);
+        return;
+    }
+    memo->mask = cap - 1;
+    memo->stats.capacity = cap;
+    ctx->memo = memo;
+}
+
+void goon_set_memory_limit(Goon_Ctx *ctx, size_t bytes) {
+    ctx->memory_limit = bytes;
+}
+
+void goon_set_threads(Goon_Ctx *ctx, size_t threads) {
+    if (ctx->parent) return;
+    pool_destroy(ctx, ctx->pool);
+    ctx->pool = threads > 1 ? pool_create(ctx, threads) : NULL;
+}
+
+void goon_get_stats(Goon_Ctx *ctx, Goon_Stats *stats) {
+    *stats = ctx->stats;
+}
+
+const Goon_Memo_Stats *goon_get_memo_stats(Goon_Ctx *ctx) {
+    return ctx->memo ? &ctx->memo->stats : NULL;
+}
+
 void goon_register(Goon_Ctx *ctx, const char *name, Goon_Builtin_Fn fn) {
-    Goon_Value *val = alloc_value(ctx);
+    Goon_Value *val = alloc_value(ctx, GOON_BUILTIN);
     if (!val) return;
-    val->type = GOON_BUILTIN;
     val->data.builtin = fn;
-    define(ctx, name, val);
+    bind(ctx, &ctx->globals, goon_intern(ctx, name), val);
+}
+
+const Goon_Symbol *goon_intern(Goon_Ctx *ctx, const char *name) {
+    if (!name) return NULL;
+    pthread_mutex_t *lock = shared_lock(ctx);
+    if (lock) pthread_mutex_lock(lock);
+    const Goon_Symbol *sym = symtab_intern(ctx->symbols, name, strlen(name));
+    if (lock) pthread_mutex_unlock(lock);
+    return sym;
 }
 
-static Goon_Value *last_result = NULL;
+const char *goon_symbol_name(const Goon_Symbol *sym) {
+    return sym ? sym->name : NULL;
+}
+
+static bool load_program(Goon_Ctx *ctx, Goon_Source *src) {
+    if (!src) return false;
+    ctx->result = run_proto(ctx, src->main);
+    if (ctx->memory_exceeded) ctx->result = NULL;
+    if (!ctx->result && !ctx->error.message) set_error(ctx, src, 0, "evaluation failed");
+    return ctx->result != NULL;
+}
 
-static void set_error_from_lexer(Goon_Ctx *ctx, Lexer *lex, const char *source) {
+bool goon_load_buffer(Goon_Ctx *ctx, const char *ptr, size_t len, const char *name) {
     clear_error(ctx);
-    if (lex->error) {
-        ctx->error.message = lex->error;
-        lex->error = NULL;
-    }
-    ctx->error.line = lex->error_line > 0 ? lex->error_line : lex->line;
-    ctx->error.col = lex->error_col > 0 ? lex->error_col : lex->col;
-    if (ctx->base_path) {
-        ctx->error.file = strdup(ctx->base_path);
-    }
-    size_t line_start = lex->line_start;
-    if (lex->error_line > 0 && lex->error_line < lex->line) {
-        const char *p = source;
-        size_t cur_line = 1;
-        while (*p && cur_line < lex->error_line) {
-            if (*p == '\n') cur_line++;
-            p++;
-        }
-        line_start = p - source;
+    if (len > UINT32_MAX) {
+        set_error(ctx, NULL, 0, "source too large");
+        return false;
     }
-    ctx->error.source_line = get_source_line(source, line_start);
+    if (!name) name = ctx->base_path;
+    prefetch_start(ctx, name, ptr, len);
+    bool ok = load_program(ctx, load_source(ctx, name, (char *)ptr, len, false, true, NULL));
+    sources_detach(ctx);
+    return ok;
 }
 
 bool goon_load_string(Goon_Ctx *ctx, const char *source) {
-    Lexer lex;
-    lexer_init(&lex, source);
-
-    Parser parser;
-    parser.ctx = ctx;
-    parser.lex = &lex;
+    return goon_load_buffer(ctx, source, strlen(source), NULL);
+}
 
-    if (!lexer_next(&lex)) {
-        set_error_from_lexer(ctx, &lex, source);
+bool goon_load_file(Goon_Ctx *ctx, const char *path) {
+    clear_error(ctx);
+    size_t len;
+    bool mapped;
+    char *text = read_file(path, &len, &mapped);
+    if (!text) {
+        ctx->error.message = strdup("could not open file");
+        ctx->error.file = strdup(path);
         return false;
     }
 
-    last_result = NULL;
+    if (ctx->base_path) free(ctx->base_path);
+    ctx->base_path = strdup(path);
 
-    while (lex.current.type != TOK_EOF) {
-        Goon_Value *expr = parse_expr(&parser);
-        if (!expr) {
-            set_error_from_lexer(ctx, &lex, source);
-            return false;
+    prefetch_start(ctx, path, text, len);
+    return load_program(ctx, load_source(ctx, path, text, len, mapped, false, NULL));
+}
+
+static void disasm_proto(String_Builder *sb, Proto *proto, const char *label) {
+    char line[256];
+    size_t line_no, col;
+    source_position(proto->src, proto->def_pos, &line_no, &col);
+    snprintf(line, sizeof(line), "== %s @ %s:%zu:%zu (params %zu, locals %zu, captures %zu, stack %zu)\n",
+             label, proto->src->name ? proto->src->name : "<string>", line_no, col,
+             proto->param_count, proto->local_count, proto->capture_count, proto->max_stack);
+    sb_append(sb, line);
+
+    size_t pc = 0;
+    while (pc < proto->code_len) {
+        Opcode op = (Opcode)proto->code[pc];
+        snprintf(line, sizeof(line), op_info[op].operands ? "%04zu  %-14s" : "%04zu  %s", pc, op_info[op].name);
+        sb_append(sb, line);
+        const uint32_t *operands = &proto->code[pc + 1];
+        size_t width = 1 + op_info[op].operands;
+        if (op == OP_SET_PATH) width += operands[0];
+
+        for (size_t i = 0; i < op_info[op].operands; i++) {
+            snprintf(line, sizeof(line), " %u", operands[i]);
+            sb_append(sb, line);
+        }
+
+        switch (op) {
+            case OP_CONST: {
+                Goon_Value *k = proto->consts[operands[0]];
+                if (value_type(k) == GOON_SEQ && seq_is_range(k)) {
+                    snprintf(line, sizeof(line), "    ; [%" PRId64 "..%" PRId64 "]", k->data.seq.start,
+                             seq_int(k, k->data.seq.len) - k->data.seq.step);
+                    sb_append(sb, line);
+                    break;
+                }
+                if (goon_list_len(k) > FOLD_LIST_MAX) {
+                    snprintf(line, sizeof(line), "    ; [%zu items]", goon_list_len(k));
+                    sb_append(sb, line);
+                    break;
+                }
+                char *json = goon_to_json(k);
+                sb_append(sb, "    ; ");
+                if (json) sb_append(sb, json);
+                free(json);
+                break;
+            }
+            case OP_LOAD_LOCAL:
+            case OP_STORE_LOCAL:
+                sb_append(sb, "    ; ");
+                sb_append(sb, proto->locals[operands[0]]->name);
+                break;
+            case OP_LOAD_CAPTURE:
+                sb_append(sb, "    ; ");
+                sb_append(sb, proto->captures[operands[0]].name->name);
+                break;
+            case OP_LOAD_GLOBAL:
+            case OP_GET_FIELD:
+            case OP_SET_FIELD:
+                sb_append(sb, "    ; ");
+                sb_append(sb, proto->names[operands[0]]->name);
+                break;
+            case OP_SET_PATH:
+                sb_append(sb, "    ;");
+                for (size_t i = 0; i < operands[0]; i++) {
+                    sb_append(sb, i == 0 ? " " : ".");
+                    sb_append(sb, proto->names[operands[1 + i]]->name);
+                }
+                break;
+            case OP_IMPORT:
+                sb_append(sb, "    ; ");
+                sb_append(sb, proto->consts[operands[0]]->data.string.ptr);
+                break;
+            default:
+                break;
         }
-        last_result = expr;
+        sb_append_char(sb, '\n');
+        pc += width;
     }
 
-    return true;
+    for (size_t i = 0; i < proto->proto_count; i++) {
+        sb_append_char(sb, '\n');
+        disasm_proto(sb, proto->protos[i], "lambda");
+    }
 }
 
-bool goon_load_file(Goon_Ctx *ctx, const char *path) {
-    FILE *f = fopen(path, "r");
-    if (!f) {
-        clear_error(ctx);
+
+char *goon_disasm_file(Goon_Ctx *ctx, const char *path) {
+    clear_error(ctx);
+    size_t len;
+    bool mapped;
+    char *text = read_file(path, &len, &mapped);
+    if (!text) {
         ctx->error.message = strdup("could not open file");
         ctx->error.file = strdup(path);
-        return false;
-    }
-
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    char *source = malloc(size + 1);
-    if (!source) {
-        fclose(f);
-        clear_error(ctx);
-        ctx->error.message = strdup("out of memory");
-        return false;
+        return NULL;
     }
 
-    size_t read_size = fread(source, 1, size, f);
-    source[read_size] = '\0';
-    fclose(f);
-
-    ctx->base_path = strdup(path);
+    Goon_Source *src = load_source(ctx, path, text, len, mapped, false, NULL);
+    if (!src) return NULL;
 
-    bool result = goon_load_string(ctx, source);
-    free(source);
-    return result;
+    String_Builder sb;
+    sb_init(&sb);
+    disasm_proto(&sb, src->main, "main");
+    return sb.buf;
 }
 
 const char *goon_get_error(Goon_Ctx *ctx) {
@@ -1472,58 +5460,49 @@ void goon_error_print(const Goon_Error *err) {
 }
 
 Goon_Value *goon_eval_result(Goon_Ctx *ctx) {
-    (void)ctx;
-    return last_result;
+    return force_slot(&ctx->result);
 }
 
-typedef struct {
-    char *buf;
-    size_t len;
-    size_t cap;
-} String_Builder;
-
-static void sb_init(String_Builder *sb) {
-    sb->buf = malloc(256);
-    sb->len = 0;
-    sb->cap = 256;
-    if (sb->buf) sb->buf[0] = '\0';
-}
-
-static void sb_append(String_Builder *sb, const char *str) {
-    if (!sb->buf) return;
-    size_t add_len = strlen(str);
-    while (sb->len + add_len + 1 > sb->cap) {
-        sb->cap *= 2;
-        sb->buf = realloc(sb->buf, sb->cap);
-        if (!sb->buf) return;
-    }
-    memcpy(sb->buf + sb->len, str, add_len + 1);
-    sb->len += add_len;
-}
-
-static void sb_append_char(String_Builder *sb, char c) {
-    char tmp[2] = {c, '\0'};
-    sb_append(sb, tmp);
-}
-
-static void json_escape_string(String_Builder *sb, const char *str) {
+static void json_escape_string(String_Builder *sb, const char *str, size_t len) {
     sb_append_char(sb, '"');
-    while (*str) {
-        switch (*str) {
-            case '"':  sb_append(sb, "\\\""); break;
-            case '\\': sb_append(sb, "\\\\"); break;
-            case '\n': sb_append(sb, "\\n"); break;
-            case '\r': sb_append(sb, "\\r"); break;
-            case '\t': sb_append(sb, "\\t"); break;
-            default:   sb_append_char(sb, *str); break;
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        const char *esc;
+        switch (str[i]) {
+            case '"':  esc = "\\\""; break;
+            case '\\': esc = "\\\\"; break;
+            case '\n': esc = "\\n"; break;
+            case '\r': esc = "\\r"; break;
+            case '\t': esc = "\\t"; break;
+            default:   continue;
         }
-        str++;
+        sb_append_len(sb, str + run, i - run);
+        sb_append_len(sb, esc, 2);
+        run = i + 1;
     }
+    sb_append_len(sb, str + run, len - run);
     sb_append_char(sb, '"');
 }
 
 static void value_to_json(String_Builder *sb, Goon_Value *val, int indent, int depth);
 
+static void json_ints(String_Builder *sb, Goon_Value *list, size_t len) {
+    char buf[1024];
+    size_t used = 0;
+    bool flat = list->type == GOON_LIST;
+    sb_append_char(sb, '[');
+    for (size_t i = 0; i < len; i++) {
+        if (used > sizeof(buf) - 24) {
+            sb_append_len(sb, buf, used);
+            used = 0;
+        }
+        if (i > 0) buf[used++] = ',';
+        used += format_int(buf + used, flat ? int_value(list->data.list.items[i]) : seq_int(list, i));
+    }
+    sb_append_len(sb, buf, used);
+    sb_append_char(sb, ']');
+}
+
 static void append_indent(String_Builder *sb, int indent, int depth) {
     if (indent <= 0) return;
     for (int i = 0; i < indent * depth; i++) {
@@ -1532,59 +5511,73 @@ static void append_indent(String_Builder *sb, int indent, int depth) {
 }
 
 static void value_to_json(String_Builder *sb, Goon_Value *val, int indent, int depth) {
-    if (!val || val->type == GOON_NIL) {
-        sb_append(sb, "null");
-        return;
-    }
+    val = force(val);
+    switch (goon_type(val)) {
+        case GOON_NIL:
+            sb_append(sb, "null");
+            break;
 
-    switch (val->type) {
         case GOON_BOOL:
-            sb_append(sb, val->data.boolean ? "true" : "false");
+            sb_append(sb, val == VALUE_TRUE ? "true" : "false");
             break;
 
         case GOON_INT: {
-            char num[32];
-            snprintf(num, sizeof(num), "%ld", val->data.integer);
-            sb_append(sb, num);
+            char num[24];
+            sb_append_len(sb, num, format_int(num, int_value(val)));
             break;
         }
 
         case GOON_STRING:
-            json_escape_string(sb, val->data.string);
+            json_escape_string(sb, val->data.string.ptr, val->data.string.len);
             break;
 
         case GOON_LIST: {
+            size_t len = goon_list_len(val);
+            bool ints = val->type == GOON_LIST ? list_kind(val) == LIST_INTS : seq_is_range(val);
+            if (ints && indent <= 0) {
+                json_ints(sb, val, len);
+                break;
+            }
             sb_append_char(sb, '[');
-            if (indent > 0 && val->data.list.len > 0) sb_append_char(sb, '\n');
-            for (size_t i = 0; i < val->data.list.len; i++) {
+            if (indent > 0 && len > 0) sb_append_char(sb, '\n');
+            for (size_t i = 0; i < len; i++) {
                 if (indent > 0) append_indent(sb, indent, depth + 1);
-                value_to_json(sb, val->data.list.items[i], indent, depth + 1);
-                if (i < val->data.list.len - 1) sb_append_char(sb, ',');
+                if (val->type == GOON_LIST) {
+                    value_to_json(sb, val->data.list.items[i], indent, depth + 1);
+                } else if (seq_is_range(val)) {
+                    char num[24];
+                    sb_append_len(sb, num, format_int(num, seq_int(val, i)));
+                } else {
+                    Goon_Ctx *ctx = val->data.seq.ctx;
+                    bool scratch = scratch_begin(ctx);
+                    Goon_Value *item = seq_get(ctx, val, i, false);
+                    if (!item && ctx->memory_exceeded) set_error(ctx, NULL, 0, "memory limit exceeded");
+                    value_to_json(sb, item, indent, depth + 1);
+                    if (scratch) scratch_end(ctx);
+                }
+                if (i < len - 1) sb_append_char(sb, ',');
                 if (indent > 0) sb_append_char(sb, '\n');
             }
-            if (indent > 0 && val->data.list.len > 0) append_indent(sb, indent, depth);
+            if (indent > 0 && len > 0) append_indent(sb, indent, depth);
             sb_append_char(sb, ']');
             break;
         }
 
         case GOON_RECORD: {
             sb_append_char(sb, '{');
-            Goon_Record_Field *f = val->data.record.fields;
-            size_t count = 0;
-            Goon_Record_Field *tmp = f;
-            while (tmp) { count++; tmp = tmp->next; }
+            size_t count = val->data.record.size;
             if (indent > 0 && count > 0) sb_append_char(sb, '\n');
-            size_t idx = 0;
-            while (f) {
+            Goon_Record_Iter it = goon_record_iter(val);
+            for (size_t i = 0; i < count; i++) {
+                const Goon_Symbol *key;
+                Goon_Value **slot = record_iter_slot(&it, &key);
                 if (indent > 0) append_indent(sb, indent, depth + 1);
-                json_escape_string(sb, f->key);
+                json_escape_string(sb, key->name, key->len);
                 sb_append_char(sb, ':');
                 if (indent > 0) sb_append_char(sb, ' ');
-                value_to_json(sb, f->value, indent, depth + 1);
-                if (f->next) sb_append_char(sb, ',');
+                value_to_json(sb, *slot, indent, depth + 1);
+                if (i < count - 1) sb_append_char(sb, ',');
                 if (indent > 0) sb_append_char(sb, '\n');
-                f = f->next;
-                idx++;
             }
             if (indent > 0 && count > 0) append_indent(sb, indent, depth);
             sb_append_char(sb, '}');
@@ -18,50 +18,139 @@ typedef enum {
     GOON_LAMBDA,
 } Goon_Type;
 
+#define GOON_TYPE_COUNT (GOON_LAMBDA + 1)
+
 typedef struct Goon_Value Goon_Value;
 typedef struct Goon_Ctx Goon_Ctx;
 typedef struct Goon_Record_Field Goon_Record_Field;
 typedef struct Goon_Binding Goon_Binding;
+typedef struct Goon_Source Goon_Source;
+typedef struct Goon_Symbol Goon_Symbol;
+typedef struct Goon_Symtab Goon_Symtab;
+typedef struct Goon_Proto Goon_Proto;
+typedef struct Goon_Vm Goon_Vm;
+typedef struct Goon_Memo Goon_Memo;
+typedef struct Goon_Arena Goon_Arena;
+typedef struct Goon_Shape Goon_Shape;
+typedef struct Goon_Pool Goon_Pool;
+typedef struct Goon_List_Part Goon_List_Part;
+typedef struct Goon_Module Goon_Module;
+typedef struct Goon_Import Goon_Import;
+typedef struct Goon_Prefetch Goon_Prefetch;
+
+typedef struct {
+    const char *ptr;
+    size_t len;
+} Goon_Str;
 
 typedef Goon_Value *(*Goon_Builtin_Fn)(Goon_Ctx *ctx, Goon_Value **args, size_t argc);
 
+struct Goon_Symbol {
+    uint32_t hash;
+    uint32_t len;
+    char name[];
+};
+
 struct Goon_Record_Field {
-    char *key;
+    const char *key;
+    const Goon_Symbol *sym;
     Goon_Value *value;
-    Goon_Record_Field *next;
 };
 
 struct Goon_Value {
     Goon_Type type;
-    struct Goon_Value *next_alloc;
+    bool frozen;
     union {
-        bool boolean;
         int64_t integer;
-        char *string;
+        struct {
+            const char *ptr;
+            size_t len;
+            Goon_Ctx *ctx;
+            const char *flat;
+            bool terminated;
+        } string;
         struct {
             Goon_Value **items;
             size_t len;
             size_t cap;
+            Goon_Ctx *ctx;
+            void *packed;
+            uint8_t kind;
         } list;
         struct {
-            Goon_Record_Field *fields;
+            Goon_Shape *shape;
+            Goon_Value **values;
+            Goon_Value *parent;
+            uint32_t cap;
+            uint32_t size;
+            uint32_t depth;
         } record;
         Goon_Builtin_Fn builtin;
         struct {
-            char **params;
-            size_t param_count;
-            char *body;
-            Goon_Binding *env;
+            Goon_Proto *proto;
+            Goon_Value **captures;
         } lambda;
+        struct {
+            Goon_Proto *proto;
+            Goon_Value **captures;
+            Goon_Value *result;
+            Goon_Ctx *ctx;
+        } thunk;
+        struct {
+            Goon_Value *source;
+            Goon_Value *fn;
+            int64_t start;
+            int64_t step;
+            size_t len;
+            Goon_Ctx *ctx;
+            Goon_List_Part *parts;
+            size_t part_count;
+        } seq;
     } data;
 };
 
 typedef struct Goon_Binding {
-    char *name;
+    const Goon_Symbol *name;
     Goon_Value *value;
     struct Goon_Binding *next;
 } Goon_Binding;
 
+typedef struct {
+    Goon_Value *record;
+    Goon_Value *level;
+    uint32_t slot;
+    size_t pos;
+    Goon_Record_Field field;
+} Goon_Record_Iter;
+
+typedef struct {
+    Goon_Shape *shape;
+    Goon_Shape *next;
+    uint32_t slot;
+} Goon_Field_Cache;
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entries;
+    size_t capacity;
+} Goon_Memo_Stats;
+
+typedef struct {
+    size_t bytes_allocated;
+    size_t bytes_reserved;
+    size_t peak_bytes;
+    size_t values[GOON_TYPE_COUNT];
+    size_t thunks;
+    size_t fields;
+    size_t shapes;
+    size_t bindings;
+    size_t string_bytes;
+    size_t module_hits;
+    size_t module_misses;
+} Goon_Stats;
+
 typedef struct {
     char *message;
     char *file;
@@ -71,24 +160,53 @@ typedef struct {
 } Goon_Error;
 
 struct Goon_Ctx {
-    Goon_Binding *env;
-    Goon_Value *values;
-    Goon_Record_Field *fields;
+    Goon_Binding *globals;
+    Goon_Value *result;
+    Goon_Arena *arena;
+    Goon_Arena *scratch;
+    bool scratch_on;
+    bool scratch_busy;
+    Goon_Shape *empty_shape;
+    Goon_Stats stats;
+    size_t memory_limit;
+    bool memory_exceeded;
     Goon_Error error;
+    Goon_Source *sources;
+    Goon_Module *modules;
+    Goon_Import *imports;
+    Goon_Prefetch *prefetch;
+    Goon_Symtab *symbols;
+    Goon_Vm *vm;
+    Goon_Memo *memo;
+    Goon_Pool *pool;
+    Goon_Ctx *parent;
+    bool lazy;
     char *base_path;
     void *userdata;
 };
 
 Goon_Ctx *goon_create(void);
+Goon_Ctx *goon_create_shared(Goon_Ctx *other);
 void goon_destroy(Goon_Ctx *ctx);
 
 void goon_set_userdata(Goon_Ctx *ctx, void *userdata);
 void *goon_get_userdata(Goon_Ctx *ctx);
 
+const Goon_Symbol *goon_intern(Goon_Ctx *ctx, const char *name);
+const char *goon_symbol_name(const Goon_Symbol *sym);
+
 void goon_register(Goon_Ctx *ctx, const char *name, Goon_Builtin_Fn fn);
 
+void goon_set_lazy(Goon_Ctx *ctx, bool lazy);
+void goon_set_memo(Goon_Ctx *ctx, size_t max_entries);
+void goon_set_memory_limit(Goon_Ctx *ctx, size_t bytes);
+void goon_set_threads(Goon_Ctx *ctx, size_t threads);
+void goon_get_stats(Goon_Ctx *ctx, Goon_Stats *stats);
+const Goon_Memo_Stats *goon_get_memo_stats(Goon_Ctx *ctx);
+
 bool goon_load_file(Goon_Ctx *ctx, const char *path);
 bool goon_load_string(Goon_Ctx *ctx, const char *source);
+bool goon_load_buffer(Goon_Ctx *ctx, const char *ptr, size_t len, const char *name);
 
 const char *goon_get_error(Goon_Ctx *ctx);
 const Goon_Error *goon_get_error_info(Goon_Ctx *ctx);
@@ -98,9 +216,13 @@ Goon_Value *goon_nil(Goon_Ctx *ctx);
 Goon_Value *goon_bool(Goon_Ctx *ctx, bool val);
 Goon_Value *goon_int(Goon_Ctx *ctx, int64_t val);
 Goon_Value *goon_string(Goon_Ctx *ctx, const char *val);
+Goon_Value *goon_string_len(Goon_Ctx *ctx, const char *val, size_t len);
+Goon_Value *goon_string_static(Goon_Ctx *ctx, const char *val);
 Goon_Value *goon_list(Goon_Ctx *ctx);
 Goon_Value *goon_record(Goon_Ctx *ctx);
 
+Goon_Type goon_type(Goon_Value *val);
+const char *goon_type_name(Goon_Type type);
 bool goon_is_nil(Goon_Value *val);
 bool goon_is_bool(Goon_Value *val);
 bool goon_is_int(Goon_Value *val);
@@ -111,18 +233,28 @@ bool goon_is_record(Goon_Value *val);
 bool goon_to_bool(Goon_Value *val);
 int64_t goon_to_int(Goon_Value *val);
 const char *goon_to_string(Goon_Value *val);
+Goon_Str goon_to_str(Goon_Value *val);
 
 void goon_list_push(Goon_Ctx *ctx, Goon_Value *list, Goon_Value *item);
 size_t goon_list_len(Goon_Value *list);
 Goon_Value *goon_list_get(Goon_Value *list, size_t index);
+const int64_t *goon_list_ints(Goon_Value *list, size_t *len);
+const Goon_Str *goon_list_strs(Goon_Value *list, size_t *len);
 
 void goon_record_set(Goon_Ctx *ctx, Goon_Value *record, const char *key, Goon_Value *value);
 Goon_Value *goon_record_get(Goon_Value *record, const char *key);
-Goon_Record_Field *goon_record_fields(Goon_Value *record);
+void goon_record_set_sym(Goon_Ctx *ctx, Goon_Value *record, const Goon_Symbol *sym, Goon_Value *value);
+Goon_Value *goon_record_get_sym(Goon_Value *record, const Goon_Symbol *sym);
+Goon_Value *goon_record_get_cached(Goon_Value *record, const Goon_Symbol *sym, Goon_Field_Cache *cache);
+size_t goon_record_len(Goon_Value *record);
+Goon_Record_Iter goon_record_iter(Goon_Value *record);
+Goon_Record_Field *goon_record_next(Goon_Record_Iter *it);
 
 Goon_Value *goon_eval_result(Goon_Ctx *ctx);
 
 char *goon_to_json(Goon_Value *val);
 char *goon_to_json_pretty(Goon_Value *val, int indent);
 
+char *goon_disasm_file(Goon_Ctx *ctx, const char *path);
+
 #endif
@@ -9,9 +9,16 @@ static void print_usage(const char *prog) {
     fprintf(stderr, "commands:\n");
     fprintf(stderr, "  eval <file>     evaluate file and output JSON\n");
     fprintf(stderr, "  check <file>    validate syntax\n");
+    fprintf(stderr, "  disasm <file>   print compiled bytecode\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "options:\n");
     fprintf(stderr, "  -p, --pretty    pretty print JSON output\n");
+    fprintf(stderr, "  --lazy          evaluate bindings and fields on demand\n");
+    fprintf(stderr, "  --select <path> output only the value at a dotted path (implies --lazy)\n");
+    fprintf(stderr, "  --memo          cache lambda results by argument\n");
+    fprintf(stderr, "  --max-memory <bytes>  fail once evaluation uses more memory\n");
+    fprintf(stderr, "  --jobs <n>      run map over large lists on n threads\n");
+    fprintf(stderr, "  --stats         print allocation statistics to stderr\n");
     fprintf(stderr, "  -h, --help      show this help\n");
     fprintf(stderr, "  -v, --version   show version\n");
 }
@@ -20,13 +27,164 @@ static void print_version(void) {
     printf("goon %s\n", GOON_VERSION);
 }
 
-static int cmd_eval(const char *path, bool pretty) {
+static Goon_Value *select_path(Goon_Value *val, const char *path) {
+    const char *seg = path;
+    while (val && *seg) {
+        const char *end = strchr(seg, '.');
+        size_t len = end ? (size_t)(end - seg) : strlen(seg);
+        char key[256];
+        if (len >= sizeof(key)) return NULL;
+        memcpy(key, seg, len);
+        key[len] = '\0';
+
+        if (goon_is_list(val)) {
+            char *num_end;
+            unsigned long index = strtoul(key, &num_end, 10);
+            if (len == 0 || *num_end != '\0') return NULL;
+            val = goon_list_get(val, index);
+        } else {
+            val = goon_record_get(val, key);
+        }
+        seg = end ? end + 1 : seg + len;
+    }
+    return val;
+}
+
+static bool parse_size(int argc, char **argv, int *i, size_t *out) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "error: %s requires a size\n", argv[*i]);
+        return false;
+    }
+    char *end;
+    unsigned long long n = strtoull(argv[*i + 1], &end, 10);
+    if (end == argv[*i + 1]) {
+        fprintf(stderr, "error: invalid size '%s'\n", argv[*i + 1]);
+        return false;
+    }
+    switch (*end) {
+        case 'k': case 'K': n <<= 10; end++; break;
+        case 'm': case 'M': n <<= 20; end++; break;
+        case 'g': case 'G': n <<= 30; end++; break;
+        default: break;
+    }
+    if (*end != '\0') {
+        fprintf(stderr, "error: invalid size '%s'\n", argv[*i + 1]);
+        return false;
+    }
+    *out = (size_t)n;
+    (*i)++;
+    return true;
+}
+
+static bool parse_jobs(int argc, char **argv, int *i, size_t *out) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "error: --jobs requires a thread count\n");
+        return false;
+    }
+    char *end;
+    unsigned long n = strtoul(argv[*i + 1], &end, 10);
+    if (end == argv[*i + 1] || *end != '\0' || n == 0) {
+        fprintf(stderr, "error: invalid thread count '%s'\n", argv[*i + 1]);
+        return false;
+    }
+    *out = (size_t)n;
+    (*i)++;
+    return true;
+}
+
+static int report_error(Goon_Ctx *ctx) {
+    const Goon_Error *err = goon_get_error_info(ctx);
+    if (err) {
+        goon_error_print(err);
+    } else {
+        fprintf(stderr, "error: unknown error\n");
+    }
+    goon_destroy(ctx);
+    return 1;
+}
+
+typedef struct {
+    bool pretty;
+    bool lazy;
+    bool memo;
+    bool stats;
+    size_t max_memory;
+    size_t jobs;
+    const char *select;
+} Eval_Options;
+
+static void print_stats(Goon_Ctx *ctx) {
+    Goon_Stats stats;
+    goon_get_stats(ctx, &stats);
+    fprintf(stderr, "bytes allocated  %zu\n", stats.bytes_allocated);
+    fprintf(stderr, "bytes reserved   %zu\n", stats.bytes_reserved);
+    fprintf(stderr, "peak bytes       %zu\n", stats.peak_bytes);
+    for (int type = 0; type < GOON_TYPE_COUNT; type++) {
+        if (stats.values[type] == 0) continue;
+        fprintf(stderr, "%-16s %zu\n", goon_type_name((Goon_Type)type), stats.values[type]);
+    }
+    if (stats.thunks) fprintf(stderr, "thunks           %zu\n", stats.thunks);
+    fprintf(stderr, "fields           %zu\n", stats.fields);
+    fprintf(stderr, "shapes           %zu\n", stats.shapes);
+    fprintf(stderr, "bindings         %zu\n", stats.bindings);
+    fprintf(stderr, "string bytes     %zu\n", stats.string_bytes);
+    fprintf(stderr, "module hits      %zu\n", stats.module_hits);
+    fprintf(stderr, "module misses    %zu\n", stats.module_misses);
+}
+
+static int cmd_eval(const char *path, const Eval_Options *opts) {
     Goon_Ctx *ctx = goon_create();
     if (!ctx) {
         fprintf(stderr, "error: failed to create context\n");
         return 1;
     }
 
+    const char *select = opts->select;
+    goon_set_lazy(ctx, opts->lazy || select);
+    if (opts->memo) goon_set_memo(ctx, 4096);
+    goon_set_memory_limit(ctx, opts->max_memory);
+    goon_set_threads(ctx, opts->jobs);
+    if (!goon_load_file(ctx, path)) {
+        if (opts->stats) print_stats(ctx);
+        return report_error(ctx);
+    }
+
+    Goon_Value *result = goon_eval_result(ctx);
+    if (result && select) {
+        result = select_path(result, select);
+        if (!result && !goon_get_error(ctx)) {
+            fprintf(stderr, "error: no value at '%s'\n", select);
+            goon_destroy(ctx);
+            return 1;
+        }
+    }
+    if (!result && goon_get_error(ctx)) {
+        return report_error(ctx);
+    }
+
+    char *json = opts->pretty ? goon_to_json_pretty(result, 2) : goon_to_json(result);
+    if (goon_get_error(ctx)) {
+        free(json);
+        return report_error(ctx);
+    }
+    if (json) {
+        printf("%s\n", json);
+        free(json);
+    }
+
+    if (opts->stats) print_stats(ctx);
+    goon_destroy(ctx);
+    return 0;
+}
+
+static int cmd_check(const char *path, size_t max_memory) {
+    Goon_Ctx *ctx = goon_create();
+    if (!ctx) {
+        fprintf(stderr, "error: failed to create context\n");
+        return 1;
+    }
+
+    goon_set_memory_limit(ctx, max_memory);
     if (!goon_load_file(ctx, path)) {
         const Goon_Error *err = goon_get_error_info(ctx);
         if (err) {
@@ -38,25 +196,19 @@ static int cmd_eval(const char *path, bool pretty) {
         return 1;
     }
 
-    Goon_Value *result = goon_eval_result(ctx);
-    char *json = pretty ? goon_to_json_pretty(result, 2) : goon_to_json(result);
-    if (json) {
-        printf("%s\n", json);
-        free(json);
-    }
-
     goon_destroy(ctx);
     return 0;
 }
 
-static int cmd_check(const char *path) {
+static int cmd_disasm(const char *path) {
     Goon_Ctx *ctx = goon_create();
     if (!ctx) {
         fprintf(stderr, "error: failed to create context\n");
         return 1;
     }
 
-    if (!goon_load_file(ctx, path)) {
+    char *listing = goon_disasm_file(ctx, path);
+    if (!listing) {
         const Goon_Error *err = goon_get_error_info(ctx);
         if (err) {
             goon_error_print(err);
@@ -67,6 +219,8 @@ static int cmd_check(const char *path) {
         return 1;
     }
 
+    printf("%s", listing);
+    free(listing);
     goon_destroy(ctx);
     return 0;
 }
@@ -94,11 +248,27 @@ int main(int argc, char **argv) {
             fprintf(stderr, "error: eval requires a file argument\n");
             return 1;
         }
-        bool pretty = false;
+        Eval_Options opts = { 0 };
         const char *path = NULL;
         for (int i = 2; i < argc; i++) {
             if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--pretty") == 0) {
-                pretty = true;
+                opts.pretty = true;
+            } else if (strcmp(argv[i], "--lazy") == 0) {
+                opts.lazy = true;
+            } else if (strcmp(argv[i], "--memo") == 0) {
+                opts.memo = true;
+            } else if (strcmp(argv[i], "--stats") == 0) {
+                opts.stats = true;
+            } else if (strcmp(argv[i], "--max-memory") == 0) {
+                if (!parse_size(argc, argv, &i, &opts.max_memory)) return 1;
+            } else if (strcmp(argv[i], "--jobs") == 0) {
+                if (!parse_jobs(argc, argv, &i, &opts.jobs)) return 1;
+            } else if (strcmp(argv[i], "--select") == 0) {
+                if (i + 1 >= argc) {
+                    fprintf(stderr, "error: --select requires a path\n");
+                    return 1;
+                }
+                opts.select = argv[++i];
             } else if (!path) {
                 path = argv[i];
             }
@@ -107,7 +277,7 @@ int main(int argc, char **argv) {
             fprintf(stderr, "error: eval requires a file argument\n");
             return 1;
         }
-        return cmd_eval(path, pretty);
+        return cmd_eval(path, &opts);
     }
 
     if (strcmp(cmd, "check") == 0) {
@@ -115,7 +285,28 @@ int main(int argc, char **argv) {
             fprintf(stderr, "error: check requires a file argument\n");
             return 1;
         }
-        return cmd_check(argv[2]);
+        size_t max_memory = 0;
+        const char *path = NULL;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--max-memory") == 0) {
+                if (!parse_size(argc, argv, &i, &max_memory)) return 1;
+            } else if (!path) {
+                path = argv[i];
+            }
+        }
+        if (!path) {
+            fprintf(stderr, "error: check requires a file argument\n");
+            return 1;
+        }
+        return cmd_check(path, max_memory);
+    }
+
+    if (strcmp(cmd, "disasm") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "error: disasm requires a file argument\n");
+            return 1;
+        }
+        return cmd_disasm(argv[2]);
     }
 
     fprintf(stderr, "error: unknown command '%s'\n", cmd);
@@ -0,0 +1,84 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../../src/goon.h"
+
+static int failures = 0;
+
+static void expect(const char *name, const char *got, const char *want) {
+    if (got && strcmp(got, want) == 0) return;
+    fprintf(stderr, "%s: expected %s, got %s\n", name, want, got ? got : "(null)");
+    failures++;
+}
+
+/* Copies src to the end of a page that is followed by an unmapped page, so
+ * any read past len faults instead of finding a NUL. */
+static char *guarded_copy(const char *src, size_t len, char **map, size_t *map_len) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t body = (len + page - 1) / page * page;
+    *map_len = body + page;
+    *map = mmap(NULL, *map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (*map == MAP_FAILED) return NULL;
+    mprotect(*map + body, page, PROT_NONE);
+    memcpy(*map + body - len, src, len);
+    return *map + body - len;
+}
+
+static void run(const char *name, const char *src, bool lazy, const char *want) {
+    size_t len = strlen(src);
+    char *map;
+    size_t map_len;
+    char *buf = guarded_copy(src, len, &map, &map_len);
+    if (!buf) {
+        fprintf(stderr, "%s: mmap failed\n", name);
+        failures++;
+        return;
+    }
+    Goon_Ctx *ctx = goon_create();
+    goon_set_lazy(ctx, lazy);
+    bool ok = goon_load_buffer(ctx, buf, len, NULL);
+    munmap(map, map_len);
+
+    if (!ok) {
+        expect(name, goon_get_error(ctx), want);
+    } else {
+        char *json = goon_to_json(goon_eval_result(ctx));
+        expect(name, json, want);
+        free(json);
+    }
+    goon_destroy(ctx);
+}
+
+int main(void) {
+    const char *program =
+        "let greet = (n) => \"hello ${n}\";\n"
+        "let tag = \"borrowed\";\n"
+        "{ plain = tag; msg = greet(\"x\"); esc = \"a\\tb\"; ids = [1..3]; }";
+    const char *want = "{\"plain\":\"borrowed\",\"msg\":\"hello x\",\"esc\":\"a\\tb\",\"ids\":[1,2,3]}";
+    run("eager", program, false, want);
+    run("lazy", program, true, want);
+    run("unterminated", "{ a = \"open", false, "unterminated string");
+
+    /* Lazy fields are evaluated after the buffer is gone; their errors keep
+     * the position but cannot quote the line. */
+    Goon_Ctx *ctx = goon_create();
+    goon_set_lazy(ctx, true);
+    char *late = strdup("let f = (x) => x;\n{ a = f(1, 2); }");
+    bool ok = goon_load_buffer(ctx, late, strlen(late), "late.goon");
+    free(late);
+    char *json = ok ? goon_to_json(goon_eval_result(ctx)) : NULL;
+    const Goon_Error *err = goon_get_error_info(ctx);
+    expect("late error", err->message, "wrong number of arguments");
+    if (err->line != 2 || err->col != 7 || err->source_line) {
+        fprintf(stderr, "late error: expected 2:7 without a source line, got %zu:%zu\n", err->line, err->col);
+        failures++;
+    }
+    free(json);
+    goon_destroy(ctx);
+
+    return failures ? 1 : 0;
+}
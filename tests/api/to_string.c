@@ -0,0 +1,46 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../../src/goon.h"
+
+static pthread_mutex_t seen_lock = PTHREAD_MUTEX_INITIALIZER;
+static const char *seen = NULL;
+static int failures = 0;
+
+/* Called from the map workers on the same unterminated literal. Every
+ * call must get the one cached copy. */
+static Goon_Value *probe(Goon_Ctx *ctx, Goon_Value **args, size_t argc) {
+    const char *first = argc == 1 ? goon_to_string(args[0]) : NULL;
+    const char *again = argc == 1 ? goon_to_string(args[0]) : NULL;
+    pthread_mutex_lock(&seen_lock);
+    if (!seen) seen = first;
+    if (!first || first != again || first != seen || strcmp(first, "shared literal") != 0) failures++;
+    pthread_mutex_unlock(&seen_lock);
+    return goon_int(ctx, 1);
+}
+
+int main(void) {
+    Goon_Ctx *ctx = goon_create();
+    goon_set_threads(ctx, 4);
+    goon_register(ctx, "probe", probe);
+    if (!goon_load_file(ctx, "tests/fixtures/to_string.goon")) {
+        fprintf(stderr, "load failed: %s\n", goon_get_error(ctx));
+        return 1;
+    }
+    if (failures) fprintf(stderr, "goon_to_string returned %d fresh copies\n", failures);
+
+    Goon_Stats stats;
+    goon_get_stats(ctx, &stats);
+    size_t before = stats.string_bytes;
+    const char *after = goon_to_string(goon_record_get(goon_eval_result(ctx), "name"));
+    goon_get_stats(ctx, &stats);
+    if (after != seen || stats.string_bytes != before) {
+        fprintf(stderr, "goon_to_string copied the string again after the map\n");
+        failures++;
+    }
+    goon_destroy(ctx);
+    return failures ? 1 : 0;
+}
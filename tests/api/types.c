@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/goon.h"
+
+static int failures = 0;
+
+static void expect_list(Goon_Ctx *ctx, Goon_Value *record, const char *key, size_t len) {
+    Goon_Value *val = goon_record_get(record, key);
+    if (goon_type(val) != GOON_LIST || !goon_is_list(val) || goon_list_len(val) != len) {
+        fprintf(stderr, "%s: expected a list of %zu, got %s: %s\n", key, len,
+                goon_type_name(goon_type(val)), goon_get_error(ctx) ? goon_get_error(ctx) : "");
+        failures++;
+    }
+}
+
+/* Ranges, views and mapped ranges are stored apart from built lists but
+ * must look like lists through the public API, lazy or not. */
+static void run(bool lazy) {
+    Goon_Ctx *ctx = goon_create();
+    goon_set_lazy(ctx, lazy);
+    const char *src =
+        "let big = [1..100];\n"
+        "{ range = [1..5]; mapped = map([1..4], (i) => { id = i; });\n"
+        "  view = [0, ...big, ...big]; built = [1, \"a\"]; }";
+    if (!goon_load_string(ctx, src)) {
+        fprintf(stderr, "load failed: %s\n", goon_get_error(ctx));
+        failures++;
+        goon_destroy(ctx);
+        return;
+    }
+    Goon_Value *result = goon_eval_result(ctx);
+    if (goon_type(result) != GOON_RECORD) {
+        fprintf(stderr, "result: expected a record\n");
+        failures++;
+    }
+    expect_list(ctx, result, "range", 5);
+    expect_list(ctx, result, "mapped", 4);
+    expect_list(ctx, result, "view", 201);
+    expect_list(ctx, result, "built", 2);
+    goon_destroy(ctx);
+}
+
+int main(void) {
+    run(false);
+    run(true);
+    for (int type = 0; type < GOON_TYPE_COUNT; type++) {
+        if (strcmp(goon_type_name((Goon_Type)type), "unknown") == 0) failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -19,7 +19,12 @@ for test in tests/valid/*.goon; do
         continue
     fi
 
-    output=$("$GOON" eval "$test" 2>&1)
+    args=()
+    if [ -f "tests/valid/${name}.args" ]; then
+        read -r -a args < "tests/valid/${name}.args"
+    fi
+
+    output=$("$GOON" eval "$test" "${args[@]}" 2>&1)
     expected_content=$(cat "$expected")
 
     if [ "$output" = "$expected_content" ]; then
@@ -42,7 +47,12 @@ for test in tests/invalid/*.goon; do
         continue
     fi
 
-    output=$("$GOON" check "$test" 2>&1)
+    args=()
+    if [ -f "tests/invalid/${name}.args" ]; then
+        read -r -a args < "tests/invalid/${name}.args"
+    fi
+
+    output=$("$GOON" check "$test" "${args[@]}" 2>&1)
     exit_code=$?
     expected_content=$(cat "$expected")
 
@@ -60,6 +70,105 @@ for test in tests/invalid/*.goon; do
     fi
 done
 
+for test in tests/bounded/*.goon; do
+    name=$(basename "$test" .goon)
+
+    args=()
+    if [ -f "tests/bounded/${name}.args" ]; then
+        read -r -a args < "tests/bounded/${name}.args"
+    fi
+
+    output=$("$GOON" eval "$test" "${args[@]}" 2>&1 | tail -c 80)
+    expected_content=$(cat "tests/bounded/${name}.expected")
+
+    if [ "$output" = "$expected_content" ]; then
+        echo -e "${green}PASS${reset} $name"
+        ((PASS++))
+    else
+        echo -e "${red}FAIL${reset} $name"
+        echo "  expected tail: $expected_content"
+        echo "  got:           $output"
+        ((FAIL++))
+    fi
+done
+
+for test in tests/disasm/*.goon; do
+    name=$(basename "$test" .goon)
+
+    output=$("$GOON" disasm "$test" 2>&1)
+    missing=()
+    while IFS= read -r pattern; do
+        echo "$output" | grep -qE -- "$pattern" || missing+=("$pattern")
+    done < "tests/disasm/${name}.expected"
+
+    if [ ${#missing[@]} -eq 0 ]; then
+        echo -e "${green}PASS${reset} $name"
+        ((PASS++))
+    else
+        echo -e "${red}FAIL${reset} $name"
+        for pattern in "${missing[@]}"; do
+            echo "  missing: $pattern"
+        done
+        ((FAIL++))
+    fi
+done
+
+for test in tests/prefetch/*.goon; do
+    name=$(basename "$test" .goon)
+
+    serial=$("$GOON" eval "$test" 2>&1)
+    prefetched=$("$GOON" eval "$test" --jobs 4 2>&1)
+    expected_content=$(cat "tests/prefetch/${name}.expected")
+
+    if [ "$serial" = "$expected_content" ] && [ "$prefetched" = "$expected_content" ]; then
+        echo -e "${green}PASS${reset} $name"
+        ((PASS++))
+    else
+        echo -e "${red}FAIL${reset} $name"
+        echo "  expected:   $expected_content"
+        echo "  serial:     $serial"
+        echo "  prefetched: $prefetched"
+        ((FAIL++))
+    fi
+done
+
+for test in tests/pipe/*.goon; do
+    name=$(basename "$test" .goon)
+
+    output=$(cat "$test" | "$GOON" eval /dev/stdin 2>&1)
+    expected_content=$(cat "tests/pipe/${name}.expected")
+
+    if [ "$output" = "$expected_content" ]; then
+        echo -e "${green}PASS${reset} $name"
+        ((PASS++))
+    else
+        echo -e "${red}FAIL${reset} $name"
+        echo "  expected: $expected_content"
+        echo "  got:      $output"
+        ((FAIL++))
+    fi
+done
+
+API_DIR=$(mktemp -d)
+trap 'rm -rf "$API_DIR"' EXIT
+
+for test in tests/api/*.c; do
+    name=$(basename "$test" .c)
+
+    if ! output=$("${CC:-cc}" -Wall -Wextra -std=c99 -o "$API_DIR/$name" "$test" src/goon.c -pthread 2>&1); then
+        echo -e "${red}FAIL${reset} $name (build)"
+        echo "  $output"
+        ((FAIL++))
+    elif output=$("$API_DIR/$name" 2>&1); then
+        echo -e "${green}PASS${reset} $name"
+        ((PASS++))
+    else
+        echo -e "${red}FAIL${reset} $name"
+        echo "  $output"
+        ((FAIL++))
+    fi
+done
+
 echo ""
 echo "Results: $PASS passed, $FAIL failed"
 